@@ -0,0 +1,499 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include "PuzzleCorpus.cpp"
+#include "PortfolioSolver.cpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <deque>
+#include <map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+
+using namespace std;
+
+// Outcome of one puzzle in a batch run
+enum PuzzleStatus {
+    PUZZLE_SOLVED,
+    PUZZLE_UNSOLVABLE,
+    PUZZLE_INVALID,
+    PUZZLE_MULTIPLE,
+    PUZZLE_TIMED_OUT,                        // over --timeout or --max-nodes
+    PUZZLE_CANCELLED
+};
+
+const char* const PUZZLE_STATUS_NAMES[] = {"solved", "unsolvable", "invalid", "multiple", "timeout", "cancelled"};
+
+// Output line for one puzzle: the solution, or its status
+template <int BoxSize>
+string formatResultLine(uint8_t status, const BasicGrid<BoxSize>& solution) {
+    switch (status) {
+        case PUZZLE_SOLVED: return formatPuzzleLine<BoxSize>(solution);
+        default: return PUZZLE_STATUS_NAMES[status];
+    }
+}
+
+// Work-stealing queue of index ranges. Each worker owns a deque of chunks,
+// takes work from the front of its own deque and steals from the back of
+// the others' once it runs dry, so each owner reads its chunks in file
+// order and a thief takes the chunks its victim would reach last.
+class ChunkQueue {
+private:
+    struct WorkerDeque {
+        mutex lock;
+        deque<pair<size_t, size_t>> chunks;
+    };
+
+    vector<unique_ptr<WorkerDeque>> deques;
+
+public:
+    // Split [0, total) into chunks and deal them out round-robin, so the
+    // workers move through the corpus together and finish chunks close to
+    // input order
+    ChunkQueue(size_t total, int workers, size_t chunkSize) {
+        for (int w = 0; w < workers; w++) {
+            deques.push_back(unique_ptr<WorkerDeque>(new WorkerDeque()));
+        }
+        size_t chunkCount = (total + chunkSize - 1) / chunkSize;
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            size_t begin = chunk * chunkSize;
+            size_t end = min(total, begin + chunkSize);
+            deques[chunk % workers]->chunks.push_back(make_pair(begin, end));
+        }
+    }
+
+    // Next range for a worker; false once every deque is empty
+    bool next(int worker, pair<size_t, size_t>& range) {
+        {
+            WorkerDeque& own = *deques[worker];
+            lock_guard<mutex> guard(own.lock);
+            if (!own.chunks.empty()) {
+                range = own.chunks.front();
+                own.chunks.pop_front();
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < deques.size(); offset++) {
+            WorkerDeque& victim = *deques[(worker + offset) % deques.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.chunks.empty()) {
+                range = victim.chunks.back();
+                victim.chunks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Batch run configuration
+struct BatchOptions {
+    string inputPath;
+    string outputPath;                       // empty for standard output (text input only)
+    string statsPath;                        // per-puzzle search counters, if set
+    int threads = 0;                         // 0 for one per hardware thread
+    int boxSize = 3;                         // 3, 4 or 5 for 9x9, 16x16, 25x25
+    string engineId = "auto";
+    string engineName = "Auto";
+    bool requireUnique = false;              // reject puzzles with several solutions
+    unsigned inferenceRules = ALL_INFERENCE_RULES;  // rules for the bitmask engine
+    int searchThreads = 1;                   // threads the constraint engine splits one puzzle across
+    SearchHeuristics heuristics;             // value order, restarts and nogoods (backtracking, constraint)
+    AutoRouting routing;                     // thresholds of the auto engine (9x9 only)
+    size_t cacheSize = 0;                    // solved-puzzle cache entries (9x9), 0 for none
+    double timeoutMs = 0;                    // per-puzzle deadline, 0 for none
+    uint64_t maxNodes = 0;                   // per-puzzle node budget, 0 for none
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+                                             // whole run: puzzles not done by then time out
+    const CancellationToken* cancel = nullptr;  // stops the solves in flight when raised
+    vector<PortfolioEntry> portfolio;        // race these engines per puzzle instead, if set
+};
+
+// Totals reported at the end of a batch run
+struct BatchStats {
+    size_t puzzles = 0;
+    size_t solved = 0;
+    size_t unsolvable = 0;
+    size_t invalid = 0;
+    size_t multiple = 0;
+    size_t timedOut = 0;
+    size_t cancelled = 0;
+    size_t resumed = 0;                      // answered from an earlier run's checkpoints
+    int threads = 0;
+    double seconds = 0;
+    RuleCounters rules;                      // inference rule firings, all workers
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    vector<size_t> wins;                     // races won, per portfolio racer
+    uint64_t routes[ROUTE_COUNT] = {0};      // puzzles per route of the auto engine
+};
+
+// Solve puzzles [begin, end) with one worker's solver instance, or race
+// them on the worker's portfolio when it has one. Puzzle i's outcome goes
+// to slot i - offset of the result vectors.
+template <int BoxSize>
+void solveRange(BasicSudokuSolver<BoxSize>& solver, PortfolioSolver<BoxSize>* portfolio,
+                const BatchOptions& options, const PuzzleCorpus& corpus, size_t begin, size_t end,
+                vector<BasicGrid<BoxSize>>& results, vector<uint8_t>& statuses,
+                vector<SearchStats>& searchStats, vector<int8_t>& winners, vector<int8_t>& routes,
+                size_t offset = 0) {
+    bool (BasicSudokuSolver<BoxSize>::*solve)() = solverEngine<BoxSize>(options.engineId);
+    for (size_t i = begin; i < end; i++) {
+        size_t slot = i - offset;
+        BasicGrid<BoxSize> grid;
+        if (!corpus.puzzle<BoxSize>(i, grid)) {
+            statuses[slot] = PUZZLE_INVALID;
+            continue;
+        }
+        solver.setBoard(grid);
+        if (!solver.isValidBoard()) {
+            statuses[slot] = PUZZLE_INVALID;
+            continue;
+        }
+        bool runDeadline = options.deadline != chrono::steady_clock::time_point::max();
+        if (runDeadline && chrono::steady_clock::now() >= options.deadline) {
+            statuses[slot] = PUZZLE_TIMED_OUT;
+            continue;
+        }
+        // The uniqueness count and the solve share the puzzle's deadline
+        SolveLimits limits = options.timeoutMs > 0 ? SolveLimits::timeout(options.timeoutMs) : SolveLimits();
+        if (runDeadline) limits.deadline = min(limits.deadline, options.deadline);
+        limits.maxNodes = options.maxNodes;
+        limits.token = options.cancel;
+        size_t solutions = 1;
+        SolveStatus status = options.requireUnique ? solver.countSolutionsWithLimits(2, limits, solutions)
+                                                   : SOLVE_SOLVED;
+        if (status == SOLVE_SOLVED && solutions != 1) {
+            statuses[slot] = solutions == 0 ? PUZZLE_UNSOLVABLE : PUZZLE_MULTIPLE;
+            continue;
+        }
+        if (status == SOLVE_SOLVED) {
+            if (portfolio) {
+                typename PortfolioSolver<BoxSize>::Result race = portfolio->solve(grid, limits);
+                status = race.status;
+                results[slot] = race.solution;
+                winners[slot] = race.winner;
+                if (!searchStats.empty() && race.winner >= 0) {
+                    searchStats[slot] = portfolio->solver(race.winner).getSearchStats();
+                }
+            } else {
+                status = solver.solveWithLimits(solve, limits);
+                results[slot] = solver.getGrid();
+                if (!searchStats.empty()) searchStats[slot] = solver.getSearchStats();
+                if (options.engineId == "auto") routes[slot] = solver.getLastRoute();
+            }
+        }
+        switch (status) {
+            case SOLVE_SOLVED: statuses[slot] = PUZZLE_SOLVED; break;
+            case SOLVE_UNSOLVABLE: statuses[slot] = PUZZLE_UNSOLVABLE; break;
+            case SOLVE_TIMED_OUT: statuses[slot] = PUZZLE_TIMED_OUT; break;
+            case SOLVE_CANCELLED: statuses[slot] = PUZZLE_CANCELLED; break;
+        }
+    }
+}
+
+// Outcomes of one chunk of a batch run: slot j holds puzzle begin + j
+template <int BoxSize>
+struct ChunkResults {
+    size_t begin = 0;
+    vector<BasicGrid<BoxSize>> results;
+    vector<uint8_t> statuses;
+    vector<SearchStats> searchStats;         // empty unless --stats is given
+    vector<int8_t> winners;
+    vector<int8_t> routes;
+
+    void reset(size_t first, size_t size, bool withStats) {
+        begin = first;
+        results.assign(size, BasicGrid<BoxSize>());
+        statuses.assign(size, PUZZLE_INVALID);
+        searchStats.assign(withStats ? size : 0, SearchStats());
+        winners.assign(size, -1);
+        routes.assign(size, -1);
+    }
+};
+
+// Writes the chunks of a batch run in input order as the workers finish
+// them. A chunk done ahead of an earlier one waits here, and no worker
+// starts a chunk more than `window` chunks past the first unwritten one, so
+// the results held at any time stay within the window.
+template <int BoxSize>
+class ReorderWindow {
+private:
+    mutex lock_;
+    condition_variable advanced_;
+    size_t window_;
+    size_t next_;                            // first chunk not yet written
+    map<size_t, ChunkResults<BoxSize>> done_;  // finished chunks after it
+    function<void(const ChunkResults<BoxSize>&)> write_;
+
+public:
+    ReorderWindow(size_t window, function<void(const ChunkResults<BoxSize>&)> write)
+        : window_(max<size_t>(1, window)), next_(0), write_(move(write)) {}
+
+    // Block until chunk `index` is within the window
+    void waitForRoom(size_t index) {
+        unique_lock<mutex> guard(lock_);
+        advanced_.wait(guard, [&]() { return index < next_ + window_; });
+    }
+
+    // Hand over a finished chunk (its results are taken); writes it and any
+    // chunks it was holding back once it is next in line
+    void complete(size_t index, ChunkResults<BoxSize>& chunk) {
+        lock_guard<mutex> guard(lock_);
+        if (index != next_) {
+            done_[index] = move(chunk);
+            return;
+        }
+        write_(chunk);
+        for (next_++; !done_.empty() && done_.begin()->first == next_; next_++) {
+            write_(done_.begin()->second);
+            done_.erase(done_.begin());
+        }
+        advanced_.notify_all();
+    }
+};
+
+// Solve every puzzle of a file on all cores and write one result per
+// puzzle, in input order, as soon as every puzzle before it is done. Text
+// input gives one line per puzzle: the solution, or "invalid" /
+// "unsolvable" / "multiple" / "timeout". Binary input gives a binary file
+// of solutions, with an empty record where there is none.
+template <int BoxSize>
+bool runBatchOfSize(const BatchOptions& options, BatchStats& stats) {
+    PuzzleCorpus corpus;
+    if (!corpus.openFile(options.inputPath)) {
+        return false;
+    }
+    if (corpus.isBinary()) {
+        if (corpus.boxSize() != BoxSize) {
+            cerr << options.inputPath << ": grid size does not match --size\n";
+            return false;
+        }
+        if (options.outputPath.empty()) {
+            cerr << "Binary input needs --output for the binary solutions\n";
+            return false;
+        }
+    }
+    size_t count = corpus.size();
+
+    int threads = options.threads > 0 ? options.threads : (int)thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    // A portfolio runs one thread per racer and a split search one per
+    // search thread, so fewer workers share the cores
+    if (!options.portfolio.empty()) threads = max<int>(1, threads / (int)options.portfolio.size());
+    threads = max(1, threads / options.searchThreads);
+
+    BinaryPuzzleWriter<BoxSize> binary;
+    ofstream file;
+    if (corpus.isBinary()) {
+        if (!binary.open(options.outputPath, count)) {
+            cerr << "Cannot open output file: " << options.outputPath << "\n";
+            return false;
+        }
+    } else if (!options.outputPath.empty()) {
+        file.open(options.outputPath.c_str());
+        if (!file) {
+            cerr << "Cannot open output file: " << options.outputPath << "\n";
+            return false;
+        }
+    }
+    ostream& output = options.outputPath.empty() ? cout : file;
+    ofstream statsFile;
+    if (!options.statsPath.empty()) {
+        statsFile.open(options.statsPath.c_str());
+        if (!statsFile) {
+            cerr << "Cannot open stats file: " << options.statsPath << "\n";
+            return false;
+        }
+    }
+
+    stats = BatchStats();
+    stats.puzzles = count;
+    stats.threads = threads;
+    stats.wins.assign(options.portfolio.size(), 0);
+
+    // Each chunk's results, its stats records (one JSON record per puzzle)
+    // and its share of the totals, in input order
+    BasicGrid<BoxSize> empty = {};
+    auto writeChunk = [&](const ChunkResults<BoxSize>& chunk) {
+        for (size_t j = 0; j < chunk.statuses.size(); j++) {
+            uint8_t status = chunk.statuses[j];
+            switch (status) {
+                case PUZZLE_SOLVED: stats.solved++; break;
+                case PUZZLE_UNSOLVABLE: stats.unsolvable++; break;
+                case PUZZLE_MULTIPLE: stats.multiple++; break;
+                case PUZZLE_TIMED_OUT: stats.timedOut++; break;
+                case PUZZLE_CANCELLED: stats.cancelled++; break;
+                default: stats.invalid++; break;
+            }
+            if (corpus.isBinary()) {
+                binary.write(status == PUZZLE_SOLVED ? chunk.results[j] : empty);
+            } else {
+                output << formatResultLine<BoxSize>(status, chunk.results[j]) << "\n";
+            }
+            if (statsFile.is_open()) {
+                statsFile << "{\"puzzle\": " << chunk.begin + j << ", \"status\": \"" << PUZZLE_STATUS_NAMES[status] << "\"";
+                if (!options.portfolio.empty()) {
+                    statsFile << ", \"winner\": ";
+                    if (chunk.winners[j] >= 0) {
+                        statsFile << "\"" << options.portfolio[chunk.winners[j]].label() << "\"";
+                    } else {
+                        statsFile << "null";
+                    }
+                }
+                if (chunk.routes[j] >= 0) {
+                    statsFile << ", \"route\": \"" << SOLVE_ROUTE_NAMES[chunk.routes[j]] << "\"";
+                }
+                statsFile << ", \"search\": " << chunk.searchStats[j].toJson() << "}\n";
+            }
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+
+    // Small chunks keep every core busy when a few puzzles are much harder
+    size_t chunkSize = max<size_t>(1, min<size_t>(256, count / (threads * 16)));
+    ChunkQueue queue(count, threads, chunkSize);
+    ReorderWindow<BoxSize> window((size_t)threads * 8, writeChunk);
+    vector<RuleCounters> ruleCounters(threads);
+    vector<vector<size_t>> wins(threads, vector<size_t>(options.portfolio.size(), 0));
+    vector<array<uint64_t, ROUTE_COUNT>> routeCounts(threads);
+    unique_ptr<SolutionCache> cache;
+    if (options.cacheSize > 0 && BoxSize == 3) cache.reset(new SolutionCache(options.cacheSize));
+    vector<thread> workers;
+    for (int w = 0; w < threads; w++) {
+        workers.push_back(thread([&, w]() {
+            BasicSudokuSolver<BoxSize> solver;
+            solver.setInferenceRules(options.inferenceRules);
+            solver.setSearchThreads(options.searchThreads);
+            solver.setSearchHeuristics(options.heuristics);
+            if (BoxSize == 3) solver.setAutoRouting(options.routing);
+            solver.setSolutionCache(cache.get());
+            unique_ptr<PortfolioSolver<BoxSize>> portfolio;
+            if (!options.portfolio.empty()) {
+                portfolio.reset(new PortfolioSolver<BoxSize>(options.portfolio));
+                portfolio->setInferenceRules(options.inferenceRules);
+            }
+            pair<size_t, size_t> range;
+            ChunkResults<BoxSize> chunk;
+            while (queue.next(w, range)) {
+                size_t index = range.first / chunkSize;
+                window.waitForRoom(index);
+                chunk.reset(range.first, range.second - range.first, statsFile.is_open());
+                solveRange(solver, portfolio.get(), options, corpus, range.first, range.second,
+                           chunk.results, chunk.statuses, chunk.searchStats, chunk.winners, chunk.routes,
+                           range.first);
+                window.complete(index, chunk);
+            }
+            ruleCounters[w] = solver.getRuleCounters();
+            for (int r = 0; r < ROUTE_COUNT; r++) routeCounts[w][r] = solver.getRouteCount((SolveRoute)r);
+            if (portfolio) {
+                ruleCounters[w].add(portfolio->getRuleCounters());
+                for (size_t r = 0; r < portfolio->size(); r++) wins[w][r] = portfolio->wins(r);
+            }
+        }));
+    }
+    for (size_t w = 0; w < workers.size(); w++) {
+        workers[w].join();
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    stats.seconds = elapsed.count();
+    for (int w = 0; w < threads; w++) {
+        stats.rules.add(ruleCounters[w]);
+        for (size_t r = 0; r < options.portfolio.size(); r++) stats.wins[r] += wins[w][r];
+        for (int r = 0; r < ROUTE_COUNT; r++) stats.routes[r] += routeCounts[w][r];
+    }
+    if (cache) {
+        stats.cacheHits = cache->hits();
+        stats.cacheMisses = cache->misses();
+    }
+
+    if (corpus.isBinary()) {
+        if (!binary.close()) {
+            cerr << "Cannot write output file: " << options.outputPath << "\n";
+            return false;
+        }
+    } else {
+        output.flush();
+    }
+    return true;
+}
+
+// Dispatch a batch run on the configured grid size
+bool runBatch(const BatchOptions& options, BatchStats& stats) {
+    switch (options.boxSize) {
+        case 3: return runBatchOfSize<3>(options, stats);
+        case 4: return runBatchOfSize<4>(options, stats);
+        case 5: return runBatchOfSize<5>(options, stats);
+        default:
+            cerr << "Unsupported box size: " << options.boxSize << "\n";
+            return false;
+    }
+}
+
+// Print the end-of-run summary
+void printBatchStats(const BatchOptions& options, const BatchStats& stats, ostream& out) {
+    out << "\n" << string(40, '-') << "\n";
+    out << "BATCH SUMMARY (" << options.engineName << ", " << stats.threads << " threads)\n";
+    out << string(40, '-') << "\n";
+    out << "Puzzles:     " << stats.puzzles << "\n";
+    out << "Solved:      " << stats.solved << "\n";
+    out << "Unsolvable:  " << stats.unsolvable << "\n";
+    out << "Invalid:     " << stats.invalid << "\n";
+    if (options.requireUnique) {
+        out << "Multiple:    " << stats.multiple << "\n";
+    }
+    if (options.timeoutMs > 0 || options.maxNodes > 0) {
+        out << "Timed out:   " << stats.timedOut << "\n";
+    }
+    if (stats.cancelled > 0) {
+        out << "Cancelled:   " << stats.cancelled << "\n";
+    }
+    if (stats.resumed > 0) {
+        out << "Resumed:     " << stats.resumed << " (from checkpoints)\n";
+    }
+    out << "Time:        " << fixed << setprecision(3) << stats.seconds * 1000.0 << " ms\n";
+    if (stats.seconds > 0) {
+        out << "Throughput:  " << fixed << setprecision(0) << (stats.puzzles - stats.resumed) / stats.seconds
+            << " puzzles/sec\n";
+    }
+    if (options.cacheSize > 0) {
+        out << "Cache:       " << stats.cacheHits << " hits, " << stats.cacheMisses << " misses\n";
+    }
+    if (!options.portfolio.empty()) {
+        out << "Race wins:\n";
+        for (size_t r = 0; r < options.portfolio.size(); r++) {
+            out << "  " << left << setw(16) << options.portfolio[r].label() << right << stats.wins[r] << "\n";
+        }
+    }
+    bool autoEngine = options.engineId == "auto" && options.portfolio.empty();
+    if (autoEngine) {
+        out << "Auto routes:\n";
+        for (int r = 0; r < ROUTE_COUNT; r++) {
+            out << "  " << left << setw(16) << SOLVE_ROUTE_NAMES[r] << right << stats.routes[r] << "\n";
+        }
+    }
+    bool bitmask = options.engineId == "bitmask" || autoEngine;
+    for (size_t r = 0; r < options.portfolio.size(); r++) bitmask |= options.portfolio[r].engineId == "bitmask";
+    if (bitmask || options.requireUnique) {
+        out << "Inference rule firings:\n";
+        for (int rule = 0; rule < RULE_COUNT; rule++) {
+            bool enabled = (options.inferenceRules >> rule) & 1;
+            out << "  " << left << setw(16) << INFERENCE_RULE_NAMES[rule] << right;
+            if (enabled) {
+                out << stats.rules.fired[rule] << "\n";
+            } else {
+                out << "off\n";
+            }
+        }
+    }
+}
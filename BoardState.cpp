@@ -0,0 +1,352 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+// What a hint asks the player to do
+enum HintKind {
+    HINT_NONE,                               // board complete, or no way forward
+    HINT_CONFLICT,                           // this digit repeats in one of its units: remove it
+    HINT_MISTAKE,                            // remove this entry: the board is solvable without it, or
+                                             // it rules out every solution by itself (see findMistake)
+    HINT_NAKED_SINGLE,                       // only this digit fits the cell
+    HINT_HIDDEN_SINGLE,                      // the digit fits nowhere else in one of the cell's units
+    HINT_SOLUTION,                           // no single left: the solution's digit for the tightest cell
+    HINT_UNKNOWN                             // the solve deadline passed before the board was settled
+};
+
+const char* const HINT_KIND_NAMES[] = {
+    "none", "conflict", "mistake", "naked-single", "hidden-single", "solution", "unknown"
+};
+
+// Whether a board can still be completed
+enum BoardSolvability {
+    BOARD_UNKNOWN,                           // not searched yet, or the search hit its deadline
+    BOARD_SOLVABLE,
+    BOARD_UNSOLVABLE
+};
+
+struct BoardHint {
+    HintKind kind;
+    int cell;                                // -1 with HINT_NONE
+    int digit;                               // digit to place, or the digit to remove
+};
+
+// Board being edited one cell at a time, for interactive play. Every edit
+// updates per-unit digit counts, the used-digit masks, the number of clashing
+// entries and the number of empty cells left without candidates, touching
+// only the cell and its peers, so legality and candidates are O(1) and
+// contradictions show up without a search.
+//
+// Solvability is answered from the last solution found: clearing a cell or
+// placing that solution's digit keeps it valid, and once the board is known
+// to be unsolvable, placing more digits keeps it so. Only a move that leaves
+// the known solution costs a search, and its cost depends on the board, not
+// on how many edits came before. A search stops at the deadline set with
+// setTimeout and leaves the answer unknown.
+template <int BoxSize>
+class BasicBoardState {
+private:
+    typedef BasicSudokuSolver<BoxSize> Solver;
+    typedef GridShape<BoxSize> Shape;
+    typedef typename Shape::Mask Mask;
+    typedef BasicGrid<BoxSize> Grid;
+
+    static constexpr int N = Shape::N;
+    static constexpr int CELLS = Shape::CELLS;
+    static constexpr const GeometryTables<BoxSize>& geo = geometry<BoxSize>;
+
+    Grid board_;
+    uint8_t counts_[Shape::UNITS][N + 1];    // entries of each digit per unit
+    Mask used_[Shape::UNITS];                // digits with a nonzero count
+    bool given_[CELLS];
+    bool dead_[CELLS];                       // empty and without candidates
+    int conflicts_;                          // entries beyond the first of a digit in a unit
+    int deadCells_;
+    int emptyCells_;
+
+    BoardSolvability known_;                 // when solvable, solution_ agrees with every filled cell
+    bool hasSolution_;
+    Grid solution_;                          // last solution found, kept when it goes stale
+    Solver solver_;
+    double timeoutMs_;                       // deadline of each search, 0 for none
+    bool expired_;                           // the search of this board hit the deadline
+
+    int unitOf(int cell, int kind) const {
+        return kind == 0 ? geo.rowOf[cell] : kind == 1 ? N + geo.colOf[cell] : 2 * N + geo.boxOf[cell];
+    }
+
+    void count(int cell, int digit, int delta) {
+        for (int kind = 0; kind < 3; kind++) {
+            int unit = unitOf(cell, kind);
+            uint8_t& entries = counts_[unit][digit];
+            if (delta > 0) {
+                if (entries >= 1) conflicts_++;
+                entries++;
+            } else {
+                entries--;
+                if (entries >= 1) conflicts_--;
+            }
+            if (entries > 0) {
+                used_[unit] |= (Mask)(1u << (digit - 1));
+            } else {
+                used_[unit] &= (Mask)~(1u << (digit - 1));
+            }
+        }
+    }
+
+    // Refresh the dead-cell flag of a cell
+    void refresh(int cell) {
+        bool dead = board_[cell] == 0 && candidates(cell) == 0;
+        deadCells_ += (int)dead - (int)dead_[cell];
+        dead_[cell] = dead;
+    }
+
+    void refreshPeers(int cell) {
+        refresh(cell);
+        for (int p = 0; p < Shape::PEERS; p++) refresh(geo.peers[cell][p]);
+    }
+
+    // The player's entry to take back from an unsolvable board. Only entries
+    // off the last solution found are suspects; the first whose removal makes
+    // the board solvable is confirmed, else the first that rules out every
+    // solution with the givens alone. When neither holds (several entries are
+    // wrong only together), the first suspect, which at least differs from a
+    // solution of the givens.
+    BoardHint findMistake() {
+        Grid reference = solution_;
+        int suspects[CELLS];
+        int suspectCount = 0;
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (!given_[cell] && board_[cell] != 0 && board_[cell] != reference[cell]) {
+                suspects[suspectCount++] = cell;
+            }
+        }
+        if (suspectCount == 0) return {HINT_NONE, -1, 0};
+
+        for (int i = 0; i < suspectCount; i++) {
+            Grid without = board_;
+            without[suspects[i]] = 0;
+            BoardSolvability result = search(without);
+            if (result == BOARD_UNKNOWN) return {HINT_UNKNOWN, -1, 0};
+            if (result == BOARD_SOLVABLE) return {HINT_MISTAKE, suspects[i], board_[suspects[i]]};
+        }
+
+        Grid givens;
+        for (int cell = 0; cell < CELLS; cell++) givens[cell] = given_[cell] ? board_[cell] : 0;
+        for (int i = 0; i < suspectCount; i++) {
+            Grid alone = givens;
+            alone[suspects[i]] = board_[suspects[i]];
+            BoardSolvability result = search(alone);
+            if (result == BOARD_UNKNOWN) return {HINT_UNKNOWN, -1, 0};
+            if (result == BOARD_UNSOLVABLE) return {HINT_MISTAKE, suspects[i], board_[suspects[i]]};
+        }
+        return {HINT_MISTAKE, suspects[0], board_[suspects[0]]};
+    }
+
+    // Search a board within the deadline, keeping its solution if found
+    BoardSolvability search(const Grid& grid) {
+        solver_.setBoard(grid);
+        SolveLimits limits = timeoutMs_ > 0 ? SolveLimits::timeout(timeoutMs_) : SolveLimits();
+        SolveStatus status = solver_.solveWithLimits(&Solver::solveBitmask, limits);
+        if (status == SOLVE_SOLVED) {
+            solution_ = solver_.getGrid();
+            hasSolution_ = true;
+            return BOARD_SOLVABLE;
+        }
+        if (status == SOLVE_UNSOLVABLE) return BOARD_UNSOLVABLE;
+        expired_ = true;
+        return BOARD_UNKNOWN;
+    }
+
+public:
+    BasicBoardState() : timeoutMs_(0), expired_(false) {
+        Grid empty;
+        empty.fill(0);
+        load(empty);
+    }
+
+    // Start over from a puzzle; its filled cells become the givens
+    void load(const Grid& puzzle) {
+        board_.fill(0);
+        memset(counts_, 0, sizeof(counts_));
+        memset(used_, 0, sizeof(used_));
+        memset(dead_, 0, sizeof(dead_));
+        conflicts_ = 0;
+        deadCells_ = 0;
+        emptyCells_ = CELLS;
+        for (int cell = 0; cell < CELLS; cell++) {
+            given_[cell] = puzzle[cell] != 0;
+            if (puzzle[cell] != 0) {
+                board_[cell] = puzzle[cell];
+                count(cell, puzzle[cell], 1);
+                emptyCells_--;
+            }
+        }
+        for (int cell = 0; cell < CELLS; cell++) refresh(cell);
+        known_ = BOARD_UNKNOWN;
+        hasSolution_ = false;
+        expired_ = false;
+    }
+
+    // Deadline of each solvability search, 0 for none
+    void setTimeout(double milliseconds) {
+        timeoutMs_ = milliseconds;
+    }
+
+    // Put a digit in a cell (0 clears it), replacing what was there
+    void set(int cell, int digit) {
+        int old = board_[cell];
+        if (old == digit) return;
+        expired_ = false;
+        if (old != 0) {
+            count(cell, old, -1);
+            emptyCells_++;
+            if (known_ == BOARD_UNSOLVABLE) known_ = BOARD_UNKNOWN;
+        }
+        board_[cell] = digit;
+        if (digit != 0) {
+            count(cell, digit, 1);
+            emptyCells_--;
+            if (known_ == BOARD_SOLVABLE && solution_[cell] != digit) known_ = BOARD_UNKNOWN;
+        }
+        refreshPeers(cell);
+    }
+
+    void clear(int cell) {
+        set(cell, 0);
+    }
+
+    int get(int cell) const {
+        return board_[cell];
+    }
+
+    bool isGiven(int cell) const {
+        return given_[cell];
+    }
+
+    const Grid& grid() const {
+        return board_;
+    }
+
+    // Digits that fit an empty cell (0 for a filled one)
+    Mask candidates(int cell) const {
+        if (board_[cell] != 0) return 0;
+        return Shape::ALL & ~(used_[geo.rowOf[cell]] | used_[N + geo.colOf[cell]] | used_[2 * N + geo.boxOf[cell]]);
+    }
+
+    // True if `digit` can go in `cell` without repeating in a row, column or
+    // box (the cell's current digit aside)
+    bool isLegal(int cell, int digit) const {
+        if (digit < 1 || digit > N) return false;
+        int own = board_[cell] == digit ? 1 : 0;
+        for (int kind = 0; kind < 3; kind++) {
+            if (counts_[unitOf(cell, kind)][digit] > own) return false;
+        }
+        return true;
+    }
+
+    int conflictCount() const {
+        return conflicts_;
+    }
+
+    int emptyCount() const {
+        return emptyCells_;
+    }
+
+    bool isComplete() const {
+        return emptyCells_ == 0 && conflicts_ == 0;
+    }
+
+    // Whether the board can still be completed. Clashes and cells without
+    // candidates answer at once, then the known outcome; a search only runs
+    // when the last move left the known solution. BOARD_UNKNOWN means it
+    // hit the deadline; the search being deterministic, it is not retried
+    // until the board changes.
+    BoardSolvability solvability() {
+        if (conflicts_ > 0 || deadCells_ > 0) return BOARD_UNSOLVABLE;
+        if (known_ == BOARD_UNKNOWN && !expired_) known_ = search(board_);
+        return known_;
+    }
+
+    bool isSolvable() {
+        return solvability() == BOARD_SOLVABLE;
+    }
+
+    // Next step for the player: first a clash or a wrong entry to take back,
+    // then a naked or hidden single, then the solution's digit for the empty
+    // cell with the fewest candidates. HINT_UNKNOWN if a search it needed hit
+    // the deadline.
+    BoardHint nextHint() {
+        BoardHint hint = {HINT_NONE, -1, 0};
+        if (conflicts_ > 0) {
+            // A clashing entry, the player's own before a given
+            for (int pass = 0; pass < 2 && hint.cell < 0; pass++) {
+                for (int cell = 0; cell < CELLS; cell++) {
+                    int digit = board_[cell];
+                    if (digit == 0 || given_[cell] != (pass == 1) || isLegal(cell, digit)) continue;
+                    hint = {HINT_CONFLICT, cell, digit};
+                    break;
+                }
+            }
+            return hint;
+        }
+        if (emptyCells_ == 0) return hint;
+
+        BoardSolvability solvable = solvability();
+        if (solvable == BOARD_UNKNOWN) return {HINT_UNKNOWN, -1, 0};
+        if (solvable == BOARD_UNSOLVABLE) {
+            // Suspects come from the last solution found, or from a solution
+            // of the givens when none was found yet
+            if (!hasSolution_) {
+                if (expired_) return {HINT_UNKNOWN, -1, 0};
+                Grid givens;
+                for (int cell = 0; cell < CELLS; cell++) givens[cell] = given_[cell] ? board_[cell] : 0;
+                solver_.setBoard(givens);
+                if (!solver_.hasConflicts() && search(givens) == BOARD_UNKNOWN) return {HINT_UNKNOWN, -1, 0};
+            }
+            if (hasSolution_) return findMistake();
+            return hint;
+        }
+
+        for (int cell = 0; cell < CELLS; cell++) {
+            Mask mask = candidates(cell);
+            if (board_[cell] == 0 && (mask & (mask - 1)) == 0) {
+                return {HINT_NAKED_SINGLE, cell, __builtin_ctz(mask) + 1};
+            }
+        }
+
+        for (int unit = 0; unit < Shape::UNITS; unit++) {
+            Mask seen = 0, twice = 0;
+            for (int i = 0; i < N; i++) {
+                Mask mask = candidates(geo.units[unit][i]);
+                twice |= seen & mask;
+                seen |= mask;
+            }
+            Mask once = seen & ~twice;
+            if (once == 0) continue;
+            int digit = __builtin_ctz(once) + 1;
+            for (int i = 0; i < N; i++) {
+                int cell = geo.units[unit][i];
+                if (candidates(cell) & once & (Mask)(1u << (digit - 1))) {
+                    return {HINT_HIDDEN_SINGLE, cell, digit};
+                }
+            }
+        }
+
+        int best = -1, fewest = N + 1;
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board_[cell] != 0) continue;
+            int options = __builtin_popcount(candidates(cell));
+            if (options < fewest) {
+                fewest = options;
+                best = cell;
+            }
+        }
+        return {HINT_SOLUTION, best, solution_[best]};
+    }
+};
+
+typedef BasicBoardState<3> BoardState;
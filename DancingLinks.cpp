@@ -0,0 +1,208 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Geometry.cpp"
+#include "SearchStats.cpp"
+#include "SolveLimits.cpp"
+
+using namespace std;
+
+// Dancing Links (Knuth's Algorithm X) over the Sudoku exact-cover matrix.
+//
+// Columns (324 constraints on a 9x9 grid, 4 per cell in general):
+//   0..80    cell (r,c) is filled
+//   81..161  row r contains digit d
+//   162..242 column c contains digit d
+//   243..323 box b contains digit d
+// Rows (729 candidates): one per (cell, digit), each covering 4 columns.
+//
+// The node pool is built once and every search restores the links it
+// changes, so one instance is reused across puzzles without rebuilding.
+template <int BoxSize>
+class BasicDancingLinks {
+private:
+    typedef GridShape<BoxSize> Shape;
+
+    static const int CELLS = Shape::CELLS;
+    static const int N = Shape::N;
+    static const int COLUMNS = 4 * CELLS;
+    static const int ROWS = N * CELLS;
+    static const int ROOT = COLUMNS;                    // header nodes are 0..COLUMNS-1
+    static const int NODES = COLUMNS + 1 + ROWS * 4;
+
+    vector<int> left, right, up, down;
+    vector<int> column;                                 // header of each node
+    vector<int> rowOf;                                  // candidate row of each node
+    vector<int> size;                                   // live nodes per column
+    vector<int> rowStart;                               // first node of each candidate row
+
+    vector<int> solution;                               // candidate rows chosen so far
+    int depth;
+    SearchStats stats;                                  // counters of the last solve
+    SolveBudget* budget;                                // limits of the owning solver, if any
+
+    void cover(int c) {
+        right[left[c]] = right[c];
+        left[right[c]] = left[c];
+        for (int i = down[c]; i != c; i = down[i]) {
+            for (int j = right[i]; j != i; j = right[j]) {
+                down[up[j]] = down[j];
+                up[down[j]] = up[j];
+                size[column[j]]--;
+            }
+        }
+    }
+
+    void uncover(int c) {
+        for (int i = up[c]; i != c; i = up[i]) {
+            for (int j = left[i]; j != i; j = left[j]) {
+                size[column[j]]++;
+                down[up[j]] = j;
+                up[down[j]] = j;
+            }
+        }
+        right[left[c]] = c;
+        left[right[c]] = c;
+    }
+
+    bool isCovered(int c) const {
+        return right[left[c]] != c;
+    }
+
+    // Algorithm X: pick the column with fewest live rows, try each row.
+    // Links are restored before returning, whether or not a cover was found.
+    bool search() {
+        stats.nodes++;
+        if (budget && budget->exhausted(stats.nodes)) {
+            return false;
+        }
+        if constexpr (SEARCH_STATS_ENABLED) {
+            if (depth > stats.maxDepth) stats.maxDepth = depth;
+        }
+        if (right[ROOT] == ROOT) {
+            return true;
+        }
+
+        int best = right[ROOT];
+        for (int c = right[best]; c != ROOT; c = right[c]) {
+            if (size[c] < size[best]) {
+                best = c;
+                if (size[c] == 0) break;
+            }
+        }
+        if (size[best] == 0) {
+            return false;
+        }
+
+        bool found = false;
+        cover(best);
+        for (int r = down[best]; r != best && !found && !(budget && budget->stopped()); r = down[r]) {
+            solution[depth++] = rowOf[r];
+            for (int j = right[r]; j != r; j = right[j]) cover(column[j]);
+
+            found = search();
+
+            for (int j = left[r]; j != r; j = left[j]) uncover(column[j]);
+            if (!found) {
+                depth--;
+                if constexpr (SEARCH_STATS_ENABLED) stats.backtracks++;
+            }
+        }
+        uncover(best);
+
+        return found;
+    }
+
+public:
+    BasicDancingLinks()
+        : left(NODES), right(NODES), up(NODES), down(NODES),
+          column(NODES), rowOf(NODES, -1), size(COLUMNS, 0), rowStart(ROWS),
+          solution(CELLS), depth(0), budget(nullptr) {
+        const GeometryTables<BoxSize>& tables = geometry<BoxSize>;
+
+        // Column headers in a circular list around the root
+        for (int c = 0; c <= COLUMNS; c++) {
+            left[c] = c == 0 ? ROOT : c - 1;
+            right[c] = c == ROOT ? 0 : c + 1;
+            up[c] = down[c] = c;
+            column[c] = c;
+        }
+
+        int node = COLUMNS + 1;
+        for (int r = 0; r < ROWS; r++) {
+            int cell = r / N, d = r % N;
+            int cols[4] = {cell, CELLS + tables.rowOf[cell] * N + d,
+                           2 * CELLS + tables.colOf[cell] * N + d, 3 * CELLS + tables.boxOf[cell] * N + d};
+
+            rowStart[r] = node;
+            for (int k = 0; k < 4; k++) {
+                int c = cols[k];
+                column[node] = c;
+                rowOf[node] = r;
+
+                // Append at the bottom of column c
+                up[node] = up[c];
+                down[node] = c;
+                down[up[c]] = node;
+                up[c] = node;
+                size[c]++;
+
+                // Link into the row's circular list
+                left[node] = k == 0 ? node + 3 : node - 1;
+                right[node] = k == 3 ? node - 3 : node + 1;
+                node++;
+            }
+        }
+    }
+
+    // Solve the board in place. Returns false if the givens conflict, no
+    // solution exists or the budget ran out, leaving the board untouched.
+    bool solve(uint8_t cells[CELLS]) {
+        // Select the rows of the givens first
+        int givenRows[CELLS];
+        int givens = 0;
+        bool consistent = true;
+        for (int cell = 0; cell < CELLS && consistent; cell++) {
+            if (cells[cell] == 0) continue;
+            int r = cell * N + cells[cell] - 1;
+            int first = rowStart[r];
+            for (int j = first, k = 0; k < 4; j = right[j], k++) {
+                if (isCovered(column[j])) consistent = false;
+            }
+            if (!consistent) break;
+            for (int j = first, k = 0; k < 4; j = right[j], k++) cover(column[j]);
+            givenRows[givens++] = r;
+        }
+
+        depth = 0;
+        stats = SearchStats();
+        StatsTimer timer;
+        bool found = consistent && search();
+        if (found) {
+            for (int i = 0; i < depth; i++) {
+                cells[solution[i] / N] = solution[i] % N + 1;
+            }
+        }
+
+        // Restore the pristine matrix for the next puzzle
+        while (givens > 0) {
+            int first = rowStart[givenRows[--givens]];
+            for (int j = left[first], k = 0; k < 4; j = left[j], k++) uncover(column[j]);
+        }
+
+        stats.searchSeconds = timer.seconds();
+        return found;
+    }
+
+    // Stop searches when this budget runs out (nullptr for no limits)
+    void setBudget(SolveBudget* limits) {
+        budget = limits;
+    }
+
+    // Counters of the last solve (no propagation step of its own)
+    const SearchStats& searchStats() const {
+        return stats;
+    }
+};
+
+typedef BasicDancingLinks<3> DancingLinks;
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Cheap measurements of a puzzle, taken before any search: the givens, then
+// the naked singles they force (filled in, as every engine would)
+struct PuzzleFeatures {
+    int cells = 0;                           // cells of the grid
+    int digits = 0;                          // digits per unit
+    int clues = 0;                           // givens
+    int candidates = 0;                      // candidates of the empty cells, from the givens alone
+    int singles = 0;                         // cells filled by naked singles
+    int open = 0;                            // empty cells left after them
+    int openCandidates = 0;                  // candidates of those cells
+    bool contradiction = false;              // the singles left a cell without candidates
+
+    // Share of the grid still open after the singles
+    double openShare() const {
+        return cells > 0 ? (double)open / cells : 0;
+    }
+
+    // Mean candidates per open cell, as a share of the digits
+    double branching() const {
+        return open > 0 ? (double)openCandidates / open / digits : 0;
+    }
+};
+
+// Where the auto engine sends a puzzle
+enum SolveRoute {
+    ROUTE_SINGLES,                           // settled by the singles: solved, or a contradiction
+    ROUTE_BACKTRACKING,                      // few open cells: no setup beats a smart search
+    ROUTE_BITMASK,
+    ROUTE_DLX,
+    ROUTE_CACHE,                             // answered by the solution cache, never measured
+    ROUTE_COUNT
+};
+
+const char* const SOLVE_ROUTE_NAMES[] = {"singles", "backtracking", "bitmask", "dlx", "cache"};
+
+// Thresholds of the auto engine on 9x9 grids. A puzzle whose singles leave at most
+// trivialOpen of the grid open goes to backtracking, which has nothing to
+// set up; of the rest, those with fewer than dlxBranching candidates per
+// open cell (as a share of the digits) go to Dancing Links, the others to
+// the bitmask engine. The defaults come from calibrateAutoRouting on the
+// benchmark corpora (sudoku_bench --calibrate, 520 distinct puzzles): the
+// easy puzzles leave at most 58% of the grid open, the hard ones 58-74% and
+// the 17-clue ones about 78%; the 17-clue ones branch 0.51-0.53, where the
+// bitmask rules do best, and the hard ones 0.38-0.48, where DLX does.
+struct AutoRouting {
+    double trivialOpen = 0.599;
+    double dlxBranching = 0.496;
+
+    SolveRoute route(const PuzzleFeatures& features) const {
+        if (features.contradiction || features.open == 0) return ROUTE_SINGLES;
+        if (features.openShare() <= trivialOpen) return ROUTE_BACKTRACKING;
+        return features.branching() < dlxBranching ? ROUTE_DLX : ROUTE_BITMASK;
+    }
+};
+
+// Routing of the larger grids. Their features spread differently (a 16x16
+// branches at 0.2-0.3 of its digits), backtracking is hopeless on them
+// whatever the share left open, and no corpus calibrates them yet, so every
+// open puzzle goes to the bitmask engine, the steadier of the other two.
+template <int BoxSize>
+inline AutoRouting defaultAutoRouting() {
+    AutoRouting routing;
+    if (BoxSize != 3) {
+        routing.trivialOpen = 0;
+        routing.dlxBranching = 0;
+    }
+    return routing;
+}
+
+// "open,branching", e.g. "0.599,0.496"
+inline bool parseAutoRouting(const string& text, AutoRouting& routing) {
+    size_t comma = text.find(',');
+    if (comma == string::npos) return false;
+    char* end;
+    double open = strtod(text.c_str(), &end);
+    if (end != text.c_str() + comma) return false;
+    double branching = strtod(text.c_str() + comma + 1, &end);
+    if (*end != '\0' || open < 0 || branching < 0) return false;
+    routing.trivialOpen = open;
+    routing.dlxBranching = branching;
+    return true;
+}
+
+// A puzzle's features and the time each route takes on it
+struct RoutingSample {
+    PuzzleFeatures features;
+    double seconds[ROUTE_COUNT] = {0};
+};
+
+// Total time of the samples under a routing
+inline double routedSeconds(const vector<RoutingSample>& samples, const AutoRouting& routing) {
+    double total = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        total += samples[i].seconds[routing.route(samples[i].features)];
+    }
+    return total;
+}
+
+// Cut points between the sorted distinct values, plus one below and one
+// above them all
+inline vector<double> thresholdCandidates(vector<double> values) {
+    sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end()), values.end());
+    vector<double> cuts;
+    cuts.push_back(0);
+    for (size_t i = 0; i + 1 < values.size(); i++) cuts.push_back((values[i] + values[i + 1]) / 2);
+    cuts.push_back(values.empty() ? 1 : values.back() + 1);
+    return cuts;
+}
+
+// Thresholds that minimize the total time of the samples. Every pair of
+// cut points between observed feature values is tried, so the result is
+// exact for the samples; larger, more varied corpora make it generalize.
+inline AutoRouting calibrateAutoRouting(const vector<RoutingSample>& samples) {
+    vector<double> shares, branchings;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (samples[i].features.open == 0 || samples[i].features.contradiction) continue;
+        shares.push_back(samples[i].features.openShare());
+        branchings.push_back(samples[i].features.branching());
+    }
+
+    AutoRouting best;
+    double bestSeconds = routedSeconds(samples, best);
+    vector<double> shareCuts = thresholdCandidates(shares), branchingCuts = thresholdCandidates(branchings);
+    for (size_t s = 0; s < shareCuts.size(); s++) {
+        for (size_t b = 0; b < branchingCuts.size(); b++) {
+            AutoRouting routing;
+            routing.trivialOpen = shareCuts[s];
+            routing.dlxBranching = branchingCuts[b];
+            double seconds = routedSeconds(samples, routing);
+            if (seconds < bestSeconds) {
+                bestSeconds = seconds;
+                best = routing;
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+using namespace std;
+
+// Compile-time grid geometry for a Sudoku with BoxSize x BoxSize boxes:
+// 9x9 for box size 3, 16x16 for 4, 25x25 for 5
+template <int BoxSize>
+struct GridShape {
+    static constexpr int BOX = BoxSize;
+    static constexpr int N = BoxSize * BoxSize;             // digits, and cells per unit
+    static constexpr int CELLS = N * N;
+    static constexpr int UNITS = 3 * N;                      // rows, then columns, then boxes
+    static constexpr int PEERS = 3 * N - 2 * BoxSize - 1;    // 20 on a 9x9 grid
+
+    // Candidate mask with one bit per digit, sized to fit
+    typedef typename conditional<N <= 16, uint16_t, uint32_t>::type Mask;
+
+    // Cell index type, sized to fit
+    typedef typename conditional<CELLS <= 256, uint8_t, uint16_t>::type Cell;
+
+    static constexpr Mask ALL = (Mask)((1ull << N) - 1);
+};
+
+// Row, column and box of each cell, the peers of each cell and the cells
+// of each unit
+template <int BoxSize>
+struct GeometryTables {
+    typedef GridShape<BoxSize> Shape;
+    typedef typename Shape::Cell Cell;
+
+    uint8_t rowOf[Shape::CELLS];
+    uint8_t colOf[Shape::CELLS];
+    uint8_t boxOf[Shape::CELLS];
+    Cell peers[Shape::CELLS][Shape::PEERS];
+    Cell units[Shape::UNITS][Shape::N];
+};
+
+template <int BoxSize>
+constexpr GeometryTables<BoxSize> makeGeometryTables() {
+    typedef GridShape<BoxSize> Shape;
+    const int n = Shape::N;
+
+    GeometryTables<BoxSize> tables{};
+    for (int cell = 0; cell < Shape::CELLS; cell++) {
+        int row = cell / n, col = cell % n;
+        int box = (row / BoxSize) * BoxSize + col / BoxSize;
+        tables.rowOf[cell] = row;
+        tables.colOf[cell] = col;
+        tables.boxOf[cell] = box;
+        tables.units[row][col] = cell;
+        tables.units[n + col][row] = cell;
+        tables.units[2 * n + box][(row % BoxSize) * BoxSize + col % BoxSize] = cell;
+    }
+
+    for (int cell = 0; cell < Shape::CELLS; cell++) {
+        int count = 0;
+        for (int other = 0; other < Shape::CELLS; other++) {
+            if (other == cell) continue;
+            if (tables.rowOf[other] == tables.rowOf[cell] || tables.colOf[other] == tables.colOf[cell] ||
+                tables.boxOf[other] == tables.boxOf[cell]) {
+                tables.peers[cell][count++] = other;
+            }
+        }
+    }
+
+    return tables;
+}
+
+// One table per grid size, generated by the compiler
+template <int BoxSize>
+constexpr GeometryTables<BoxSize> geometry = makeGeometryTables<BoxSize>();
+
+// Digit symbols: 1-9, then letters for the larger grids
+const char DIGIT_SYMBOLS[] = "123456789ABCDEFGHIJKLMNOP";
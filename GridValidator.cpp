@@ -0,0 +1,300 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Verdict on one grid from validateGrids
+struct GridCheck {
+    bool valid;                              // no digit repeats within a unit
+    bool complete;                           // no empty cell; with valid, a solved grid
+    int16_t conflictUnit;                    // first unit with a repeat (rows, then columns,
+                                             // then boxes, as in geometry.units), -1 if valid
+};
+
+// A unit holds no repeated digit exactly when the sum of its cells' digit
+// bits equals their OR: a repeat adds its bit twice. So every unit costs one
+// OR and one add per cell, with no per-unit sets or early exits, and the
+// same arithmetic runs on one grid per lane in the vector kernels.
+//
+// Cells hold 0 for empty or a digit 1..N. Any other byte counts as an empty
+// cell, so a corrupt grid is reported incomplete rather than solved.
+
+// Bit of each byte value, so the kernels do not branch on empty cells
+template <int BoxSize>
+struct DigitBitTable {
+    uint32_t bits[256];
+};
+
+template <int BoxSize>
+constexpr DigitBitTable<BoxSize> makeDigitBitTable() {
+    DigitBitTable<BoxSize> table{};
+    for (int digit = 1; digit <= GridShape<BoxSize>::N; digit++) table.bits[digit] = 1u << (digit - 1);
+    return table;
+}
+
+template <int BoxSize>
+constexpr DigitBitTable<BoxSize> digitBits = makeDigitBitTable<BoxSize>();
+
+template <int BoxSize>
+inline uint32_t gridDigitBit(uint8_t value) {
+    return digitBits<BoxSize>.bits[value];
+}
+
+// Scalar kernel for every grid size
+template <int BoxSize>
+void validateGridsScalar(const BasicGrid<BoxSize>* grids, size_t count, GridCheck* checks) {
+    typedef GridShape<BoxSize> Shape;
+    const GeometryTables<BoxSize>& geo = geometry<BoxSize>;
+    const int N = Shape::N;
+
+    for (size_t g = 0; g < count; g++) {
+        const BasicGrid<BoxSize>& grid = grids[g];
+        uint32_t ors[Shape::UNITS] = {0}, sums[Shape::UNITS] = {0};
+        bool complete = true;
+        for (int cell = 0; cell < Shape::CELLS; cell++) {
+            uint32_t bit = gridDigitBit<BoxSize>(grid[cell]);
+            complete &= bit != 0;
+            int row = geo.rowOf[cell], col = N + geo.colOf[cell], box = 2 * N + geo.boxOf[cell];
+            ors[row] |= bit;
+            sums[row] += bit;
+            ors[col] |= bit;
+            sums[col] += bit;
+            ors[box] |= bit;
+            sums[box] += bit;
+        }
+
+        GridCheck& check = checks[g];
+        check.complete = complete;
+        check.conflictUnit = -1;
+        for (int unit = 0; unit < Shape::UNITS; unit++) {
+            if (ors[unit] != sums[unit]) {
+                check.conflictUnit = unit;
+                break;
+            }
+        }
+        check.valid = check.conflictUnit < 0;
+    }
+}
+
+// Fill in the checks of a block of 9x9 grids from the vector kernels'
+// per-unit lane masks: bit g of bad[unit] is set when grid g repeats a
+// digit in that unit, bit g of empty when grid g has an empty cell
+inline void finishGridBlock(const uint32_t* bad, uint32_t empty, int lanes, GridCheck* checks) {
+    uint32_t anyBad = 0;
+    for (int unit = 0; unit < 27; unit++) anyBad |= bad[unit];
+    for (int g = 0; g < lanes; g++) {
+        GridCheck& check = checks[g];
+        check.complete = !((empty >> g) & 1);
+        check.valid = !((anyBad >> g) & 1);
+        check.conflictUnit = -1;
+        if (!check.valid) {
+            int unit = 0;
+            while (!((bad[unit] >> g) & 1)) unit++;
+            check.conflictUnit = unit;
+        }
+    }
+}
+
+#ifdef SUDOKU_X86_KERNELS
+
+// Lanes of 8 grids where a unit's OR and sum differ
+inline uint32_t mismatchSSE2(__m128i ors, __m128i sums) {
+    __m128i same = _mm_cmpeq_epi16(ors, sums);
+    return ~(uint32_t)_mm_movemask_epi8(_mm_packs_epi16(same, _mm_setzero_si128())) & 0xFFu;
+}
+
+// One bit per 16-bit lane of a compare result. packs works within each
+// 128-bit half, leaving lanes 0-7 in bits 0-7 of the byte mask and lanes
+// 8-15 in bits 16-23.
+__attribute__((target("avx2")))
+inline uint32_t laneMaskAVX2(__m256i flags) {
+    uint32_t bytes = (uint32_t)_mm256_movemask_epi8(_mm256_packs_epi16(flags, _mm256_setzero_si256()));
+    return (bytes & 0xFFu) | ((bytes >> 8) & 0xFF00u);
+}
+
+__attribute__((target("avx2")))
+inline uint32_t mismatchAVX2(__m256i ors, __m256i sums) {
+    return ~laneMaskAVX2(_mm256_cmpeq_epi16(ors, sums)) & 0xFFFFu;
+}
+
+// Transpose a 16x16 byte block in place. Each round interleaves rows i and
+// i + 8, which rotates the 8 bits of (row, column) by one; four rounds swap
+// row and column.
+inline void transposeBytes16(__m128i rows[16]) {
+    for (int round = 0; round < 4; round++) {
+        __m128i next[16];
+        for (int i = 0; i < 8; i++) {
+            next[2 * i] = _mm_unpacklo_epi8(rows[i], rows[i + 8]);
+            next[2 * i + 1] = _mm_unpackhi_epi8(rows[i], rows[i + 8]);
+        }
+        for (int i = 0; i < 16; i++) rows[i] = next[i];
+    }
+}
+
+// SSE2: 8 grids per block, one 16-bit lane each. Columns and the boxes of
+// the current band stay in registers as the rows stream through.
+inline void validateGridsSSE2(const Grid* grids, size_t count, GridCheck* checks) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t start = 0;
+    for (; start + 8 <= count; start += 8) {
+        const Grid* g = grids + start;
+        __m128i colOr[9], colSum[9], boxOr[3], boxSum[3];
+        for (int c = 0; c < 9; c++) colOr[c] = colSum[c] = zero;
+        __m128i empty = zero;
+        uint32_t bad[27];
+
+        for (int r = 0; r < 9; r++) {
+            if (r % 3 == 0) {
+                for (int b = 0; b < 3; b++) boxOr[b] = boxSum[b] = zero;
+            }
+            __m128i rowOr = zero, rowSum = zero;
+            for (int c = 0; c < 9; c++) {
+                int cell = r * 9 + c;
+                __m128i bits = _mm_set_epi16(
+                    (short)gridDigitBit<3>(g[7][cell]), (short)gridDigitBit<3>(g[6][cell]),
+                    (short)gridDigitBit<3>(g[5][cell]), (short)gridDigitBit<3>(g[4][cell]),
+                    (short)gridDigitBit<3>(g[3][cell]), (short)gridDigitBit<3>(g[2][cell]),
+                    (short)gridDigitBit<3>(g[1][cell]), (short)gridDigitBit<3>(g[0][cell]));
+                empty = _mm_or_si128(empty, _mm_cmpeq_epi16(bits, zero));
+                rowOr = _mm_or_si128(rowOr, bits);
+                rowSum = _mm_add_epi16(rowSum, bits);
+                colOr[c] = _mm_or_si128(colOr[c], bits);
+                colSum[c] = _mm_add_epi16(colSum[c], bits);
+                boxOr[c / 3] = _mm_or_si128(boxOr[c / 3], bits);
+                boxSum[c / 3] = _mm_add_epi16(boxSum[c / 3], bits);
+            }
+            bad[r] = mismatchSSE2(rowOr, rowSum);
+            if (r % 3 == 2) {
+                for (int b = 0; b < 3; b++) bad[18 + (r / 3) * 3 + b] = mismatchSSE2(boxOr[b], boxSum[b]);
+            }
+        }
+        for (int c = 0; c < 9; c++) bad[9 + c] = mismatchSSE2(colOr[c], colSum[c]);
+
+        uint32_t emptyLanes = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(empty, zero)) & 0xFFu;
+        finishGridBlock(bad, emptyLanes, 8, checks + start);
+    }
+    validateGridsScalar<3>(grids + start, count - start, checks + start);
+}
+
+// AVX2: 16 grids per block. The block is first transposed 16 cells at a
+// time, so each cell's 16 digits load as one register, and a byte shuffle
+// turns digits into their bits (the low and high byte of each 16-bit lane).
+__attribute__((target("avx2")))
+inline void validateGridsAVX2(const Grid* grids, size_t count, GridCheck* checks) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m128i ten = _mm_set1_epi8(10);
+    const __m128i lowBits = _mm_setr_epi8(0, 1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i highBits = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0);
+    const int chunks[6] = {0, 16, 32, 48, 64, 65};   // the last overlaps so no read passes cell 80
+
+    size_t start = 0;
+    for (; start + 16 <= count; start += 16) {
+        const Grid* g = grids + start;
+        alignas(16) uint8_t digits[81][16];  // digits[cell][grid]
+        for (int k = 0; k < 6; k++) {
+            __m128i rows[16];
+            for (int lane = 0; lane < 16; lane++) {
+                rows[lane] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g[lane].data() + chunks[k]));
+            }
+            transposeBytes16(rows);
+            for (int i = 0; i < 16; i++) {
+                _mm_store_si128(reinterpret_cast<__m128i*>(digits[chunks[k] + i]), rows[i]);
+            }
+        }
+
+        __m256i colOr[9], colSum[9], boxOr[3], boxSum[3];
+        for (int c = 0; c < 9; c++) colOr[c] = colSum[c] = zero;
+        __m256i empty = zero;
+        uint32_t bad[27];
+
+        for (int r = 0; r < 9; r++) {
+            if (r % 3 == 0) {
+                for (int b = 0; b < 3; b++) boxOr[b] = boxSum[b] = zero;
+            }
+            __m256i rowOr = zero, rowSum = zero;
+            for (int c = 0; c < 9; c++) {
+                int cell = r * 9 + c;
+                // Digits past 9 clamp to 10, which has no bit, like an empty cell
+                __m128i digit = _mm_min_epu8(_mm_load_si128(reinterpret_cast<const __m128i*>(digits[cell])), ten);
+                __m128i low = _mm_shuffle_epi8(lowBits, digit), high = _mm_shuffle_epi8(highBits, digit);
+                __m256i bits = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(low, high)),
+                                                       _mm_unpackhi_epi8(low, high), 1);
+                empty = _mm256_or_si256(empty, _mm256_cmpeq_epi16(bits, zero));
+                rowOr = _mm256_or_si256(rowOr, bits);
+                rowSum = _mm256_add_epi16(rowSum, bits);
+                colOr[c] = _mm256_or_si256(colOr[c], bits);
+                colSum[c] = _mm256_add_epi16(colSum[c], bits);
+                boxOr[c / 3] = _mm256_or_si256(boxOr[c / 3], bits);
+                boxSum[c / 3] = _mm256_add_epi16(boxSum[c / 3], bits);
+            }
+            bad[r] = mismatchAVX2(rowOr, rowSum);
+            if (r % 3 == 2) {
+                for (int b = 0; b < 3; b++) bad[18 + (r / 3) * 3 + b] = mismatchAVX2(boxOr[b], boxSum[b]);
+            }
+        }
+        for (int c = 0; c < 9; c++) bad[9 + c] = mismatchAVX2(colOr[c], colSum[c]);
+
+        finishGridBlock(bad, laneMaskAVX2(empty), 16, checks + start);
+    }
+    validateGridsScalar<3>(grids + start, count - start, checks + start);
+}
+
+#endif
+
+// Validation kernel chosen once per process and grid size
+template <int BoxSize>
+struct GridValidator {
+    const char* name;
+    void (*validate)(const BasicGrid<BoxSize>* grids, size_t count, GridCheck* checks);
+};
+
+// Every kernel this CPU can run, narrowest first; the benchmark times each
+template <int BoxSize>
+inline vector<GridValidator<BoxSize>> availableGridValidators() {
+    return {{"scalar", &validateGridsScalar<BoxSize>}};
+}
+
+template <>
+inline vector<GridValidator<3>> availableGridValidators<3>() {
+    vector<GridValidator<3>> validators = {{"scalar", &validateGridsScalar<3>}};
+#ifdef SUDOKU_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) validators.push_back({"sse2", &validateGridsSSE2});
+    if (__builtin_cpu_supports("avx2")) validators.push_back({"avx2", &validateGridsAVX2});
+#endif
+    return validators;
+}
+
+// Widest kernel, or the one SUDOKU_KERNEL=scalar|sse2|avx2 names, as for
+// the propagation kernels
+template <int BoxSize>
+inline GridValidator<BoxSize> selectGridValidator() {
+    vector<GridValidator<BoxSize>> validators = availableGridValidators<BoxSize>();
+    const char* forced = getenv("SUDOKU_KERNEL");
+    if (forced) {
+        for (size_t i = 0; i < validators.size(); i++) {
+            if (validators[i].name == string(forced)) return validators[i];
+        }
+    }
+    return validators.back();
+}
+
+template <int BoxSize>
+inline const GridValidator<BoxSize>& gridValidator() {
+    static const GridValidator<BoxSize> validator = selectGridValidator<BoxSize>();
+    return validator;
+}
+
+// Check `count` grids at once, writing one verdict per grid into `checks`
+template <int BoxSize>
+inline void validateGrids(const BasicGrid<BoxSize>* grids, size_t count, GridCheck* checks) {
+    gridValidator<BoxSize>().validate(grids, count, checks);
+}
+
+inline void validateGrids(const Grid* grids, size_t count, GridCheck* checks) {
+    validateGrids<3>(grids, count, checks);
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Geometry.cpp"
+#include "PropagationKernel.cpp"
+
+using namespace std;
+
+// Inference rules run at every node of the bitmask search, on top of the
+// naked singles the propagation kernel always fills. Each one only removes
+// candidates that no solution can use, so none of them changes the set of
+// solutions; they only shrink the tree the search has to explore.
+enum InferenceRule {
+    RULE_HIDDEN_SINGLES,    // a digit with one place left in a unit goes there
+    RULE_NAKED_PAIRS,       // two cells of a unit holding the same two digits own them
+    RULE_HIDDEN_PAIRS,      // two digits confined to the same two cells of a unit fill them
+    RULE_POINTING,          // a digit confined to one line within a box leaves the rest of the line
+    RULE_BOX_LINE,          // a digit confined to one box within a line leaves the rest of the box
+    RULE_COUNT
+};
+
+const char* const INFERENCE_RULE_NAMES[RULE_COUNT] = {
+    "hidden-singles", "naked-pairs", "hidden-pairs", "pointing", "box-line"
+};
+
+const unsigned ALL_INFERENCE_RULES = (1u << RULE_COUNT) - 1;
+
+// Parse a comma-separated list of rule names, or "all" / "none"
+inline bool parseInferenceRules(const string& list, unsigned& rules) {
+    if (list == "all") {
+        rules = ALL_INFERENCE_RULES;
+        return true;
+    }
+    rules = 0;
+    if (list == "none") return true;
+
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == string::npos) end = list.size();
+        string name = list.substr(start, end - start);
+        int rule = 0;
+        while (rule < RULE_COUNT && name != INFERENCE_RULE_NAMES[rule]) rule++;
+        if (rule == RULE_COUNT) return false;
+        rules |= 1u << rule;
+        start = end + 1;
+    }
+    return true;
+}
+
+// How many cells each rule changed
+struct RuleCounters {
+    uint64_t fired[RULE_COUNT];
+
+    RuleCounters() {
+        memset(fired, 0, sizeof(fired));
+    }
+
+    void add(const RuleCounters& other) {
+        for (int rule = 0; rule < RULE_COUNT; rule++) fired[rule] += other.fired[rule];
+    }
+};
+
+// Result of one pass over the rules
+enum RuleOutcome {
+    RULES_NO_PROGRESS,
+    RULES_PROGRESS,
+    RULES_CONTRADICTION
+};
+
+template <int BoxSize>
+class InferenceEngine {
+private:
+    typedef GridShape<BoxSize> Shape;
+    typedef typename Shape::Mask Mask;
+    typedef BasicCandidateGrid<BoxSize> CandidateGrid;
+
+    static const int N = Shape::N;
+
+    // Clear `digits` from an open cell; true if anything was removed
+    static bool eliminate(CandidateGrid& grid, int cell, Mask digits) {
+        if (!grid.isOpen(cell) || (grid.cells[cell] & digits) == 0) return false;
+        grid.cells[cell] &= ~digits;
+        return true;
+    }
+
+    // Bits of the unit positions sharing a group of BoxSize consecutive
+    // positions (a row of a box, or a box's stretch of a line)
+    static uint32_t groupMask(int group) {
+        return ((1u << BoxSize) - 1) << (group * BoxSize);
+    }
+
+    // Bits of the box positions in box column `offset`
+    static uint32_t boxColumnMask(int offset) {
+        uint32_t mask = 0;
+        for (int r = 0; r < BoxSize; r++) mask |= 1u << (r * BoxSize + offset);
+        return mask;
+    }
+
+public:
+    // One pass of the enabled rules over every unit. Works on the candidate
+    // grid alone: the kernel has already cleared every placed digit from its
+    // peers, so only digits still missing from a unit show up as candidates.
+    static RuleOutcome apply(CandidateGrid& grid, unsigned rules, RuleCounters* counters) {
+        const GeometryTables<BoxSize>& geo = geometry<BoxSize>;
+        bool progress = false;
+
+        for (int unit = 0; unit < Shape::UNITS; unit++) {
+            const typename Shape::Cell* cells = geo.units[unit];
+
+            // Where each digit can still go, as bits over unit positions
+            uint32_t positions[N];
+            memset(positions, 0, sizeof(positions));
+            Mask possible = 0;
+            int openCells = 0;
+            for (int i = 0; i < N; i++) {
+                int cell = cells[i];
+                if (!grid.isOpen(cell)) continue;
+                openCells++;
+                possible |= grid.cells[cell];
+                for (unsigned bits = grid.cells[cell]; bits != 0; bits &= bits - 1) {
+                    positions[__builtin_ctz(bits)] |= 1u << i;
+                }
+            }
+
+            // Every missing digit needs a home: fewer candidate digits than
+            // open cells means one of them has none left
+            if (__builtin_popcount(possible) < openCells) return RULES_CONTRADICTION;
+
+            if (rules & (1u << RULE_HIDDEN_SINGLES)) {
+                for (int d = 0; d < N; d++) {
+                    if (__builtin_popcount(positions[d]) != 1) continue;
+                    int cell = cells[__builtin_ctz(positions[d])];
+                    Mask digit = (Mask)(1u << d);
+                    if ((grid.cells[cell] & digit) == 0) return RULES_CONTRADICTION;
+                    if (grid.cells[cell] != digit) {
+                        grid.cells[cell] = digit;
+                        progress = true;
+                        if (counters) counters->fired[RULE_HIDDEN_SINGLES]++;
+                    }
+                }
+            }
+
+            if (rules & (1u << RULE_NAKED_PAIRS)) {
+                for (int i = 0; i < N; i++) {
+                    Mask pair = grid.cells[cells[i]];
+                    if (!grid.isOpen(cells[i]) || __builtin_popcount(pair) != 2) continue;
+                    for (int j = i + 1; j < N; j++) {
+                        if (!grid.isOpen(cells[j]) || grid.cells[cells[j]] != pair) continue;
+                        for (int k = 0; k < N; k++) {
+                            if (k == i || k == j) continue;
+                            if (eliminate(grid, cells[k], pair)) {
+                                progress = true;
+                                if (counters) counters->fired[RULE_NAKED_PAIRS]++;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (rules & (1u << RULE_HIDDEN_PAIRS)) {
+                for (int d1 = 0; d1 < N; d1++) {
+                    if (__builtin_popcount(positions[d1]) != 2) continue;
+                    for (int d2 = d1 + 1; d2 < N; d2++) {
+                        if (positions[d2] != positions[d1]) continue;
+                        Mask pair = (Mask)((1u << d1) | (1u << d2));
+                        for (uint32_t bits = positions[d1]; bits != 0; bits &= bits - 1) {
+                            if (eliminate(grid, cells[__builtin_ctz(bits)], (Mask)~pair)) {
+                                progress = true;
+                                if (counters) counters->fired[RULE_HIDDEN_PAIRS]++;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Box units: a digit confined to one row or column of the box
+            if ((rules & (1u << RULE_POINTING)) && unit >= 2 * N) {
+                int box = unit - 2 * N;
+                int startRow = (box / BoxSize) * BoxSize, startCol = (box % BoxSize) * BoxSize;
+                for (int d = 0; d < N; d++) {
+                    if (positions[d] == 0) continue;
+                    Mask digit = (Mask)(1u << d);
+                    for (int offset = 0; offset < BoxSize; offset++) {
+                        if ((positions[d] & ~groupMask(offset)) == 0) {
+                            const typename Shape::Cell* line = geo.units[startRow + offset];
+                            for (int c = 0; c < N; c++) {
+                                if (c / BoxSize == startCol / BoxSize) continue;
+                                if (eliminate(grid, line[c], digit)) {
+                                    progress = true;
+                                    if (counters) counters->fired[RULE_POINTING]++;
+                                }
+                            }
+                        }
+                        if ((positions[d] & ~boxColumnMask(offset)) == 0) {
+                            const typename Shape::Cell* line = geo.units[N + startCol + offset];
+                            for (int r = 0; r < N; r++) {
+                                if (r / BoxSize == startRow / BoxSize) continue;
+                                if (eliminate(grid, line[r], digit)) {
+                                    progress = true;
+                                    if (counters) counters->fired[RULE_POINTING]++;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Row and column units: a digit confined to one box of the line
+            if ((rules & (1u << RULE_BOX_LINE)) && unit < 2 * N) {
+                bool isRow = unit < N;
+                int line = isRow ? unit : unit - N;
+                for (int d = 0; d < N; d++) {
+                    if (positions[d] == 0) continue;
+                    Mask digit = (Mask)(1u << d);
+                    for (int group = 0; group < BoxSize; group++) {
+                        if ((positions[d] & ~groupMask(group)) != 0) continue;
+                        int box = isRow ? (line / BoxSize) * BoxSize + group
+                                        : group * BoxSize + line / BoxSize;
+                        const typename Shape::Cell* boxCells = geo.units[2 * N + box];
+                        for (int i = 0; i < N; i++) {
+                            int cell = boxCells[i];
+                            int cellLine = isRow ? geo.rowOf[cell] : geo.colOf[cell];
+                            if (cellLine == line) continue;
+                            if (eliminate(grid, cell, digit)) {
+                                progress = true;
+                                if (counters) counters->fired[RULE_BOX_LINE]++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return progress ? RULES_PROGRESS : RULES_NO_PROGRESS;
+    }
+};
@@ -0,0 +1,285 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+// Solver entry point for an engine id
+template <int BoxSize>
+bool (BasicSudokuSolver<BoxSize>::*solverEngine(const string& id))() {
+    typedef BasicSudokuSolver<BoxSize> Solver;
+    if (id == "backtracking") return &Solver::solveBacktracking;
+    if (id == "constraint") return &Solver::solveConstraintPropagation;
+    if (id == "bitmask") return &Solver::solveBitmask;
+    if (id == "auto") return &Solver::solveAuto;
+    return &Solver::solveDancingLinks;
+}
+
+inline bool isSolverEngine(const string& id) {
+    return id == "backtracking" || id == "constraint" || id == "bitmask" || id == "dlx" || id == "auto";
+}
+
+// One racer of a portfolio: an engine, and the seed of the random symmetry
+// it sees the puzzle through (0 for the puzzle as given). The same engine
+// under different symmetries branches on different cells and digits first,
+// so its run times on a hard puzzle spread out and the fastest one wins.
+struct PortfolioEntry {
+    string engineId;
+    uint64_t seed = 0;
+
+    string label() const {
+        return seed == 0 ? engineId : engineId + ":" + to_string(seed);
+    }
+};
+
+const char* const DEFAULT_PORTFOLIO = "dlx,bitmask,bitmask:1,constraint";
+
+// Parse a comma-separated list of engine[:seed] racers
+inline bool parsePortfolio(const string& spec, vector<PortfolioEntry>& entries) {
+    entries.clear();
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == string::npos) end = spec.size();
+        string item = spec.substr(start, end - start);
+        size_t colon = item.find(':');
+
+        PortfolioEntry entry;
+        entry.engineId = item.substr(0, colon);
+        if (!isSolverEngine(entry.engineId)) return false;
+        if (colon != string::npos) {
+            string seed = item.substr(colon + 1);
+            if (seed.empty() || seed.find_first_not_of("0123456789") != string::npos) return false;
+            entry.seed = strtoull(seed.c_str(), nullptr, 10);
+        }
+        entries.push_back(entry);
+        start = end + 1;
+    }
+    return !entries.empty();
+}
+
+// Races several engines on one puzzle, each racer on its own thread with its
+// own solver. The first racer to settle the puzzle (solved, or proven to
+// have no solution) wins; the rest are cancelled cooperatively through the
+// race token and stop within a node. The threads are started once and wait
+// between puzzles, so a race costs two wake-ups, not thread creation.
+template <int BoxSize>
+class PortfolioSolver {
+private:
+    typedef BasicSudokuSolver<BoxSize> Solver;
+    typedef BasicGrid<BoxSize> Grid;
+    static const int N = GridShape<BoxSize>::N;
+    static const int CELLS = GridShape<BoxSize>::CELLS;
+
+    struct Racer {
+        PortfolioEntry entry;
+        bool (Solver::*solve)();
+        Solver solver;
+        bool transpose;
+        int rows[N];                         // racer's row r is row rows[r] of the puzzle
+        int cols[N];
+        uint8_t digits[N + 1];               // racer's digit for each puzzle digit
+        uint64_t wins;
+        thread worker;
+
+        // Cell of the puzzle behind the racer's cell (r, c)
+        int source(int r, int c) const {
+            return transpose ? cols[c] * N + rows[r] : rows[r] * N + cols[c];
+        }
+
+        void toRacer(const Grid& puzzle, Grid& grid) const {
+            for (int r = 0; r < N; r++) {
+                for (int c = 0; c < N; c++) grid[r * N + c] = digits[puzzle[source(r, c)]];
+            }
+        }
+
+        void fromRacer(const Grid& grid, Grid& puzzle) const {
+            uint8_t inverse[N + 1];
+            for (int d = 0; d <= N; d++) inverse[digits[d]] = d;
+            for (int r = 0; r < N; r++) {
+                for (int c = 0; c < N; c++) puzzle[source(r, c)] = inverse[grid[r * N + c]];
+            }
+        }
+    };
+
+    vector<unique_ptr<Racer>> racers_;
+    mutex lock_;
+    condition_variable start_;
+    condition_variable finished_;
+    uint64_t round_;                         // bumped for every race
+    size_t running_;                         // racers still busy this round
+    bool shutdown_;
+    Grid puzzle_;
+    SolveLimits limits_;
+    CancellationToken race_;
+    int winner_;
+    SolveStatus status_;
+    Grid solution_;
+
+    PortfolioSolver(const PortfolioSolver&) = delete;
+    PortfolioSolver& operator=(const PortfolioSolver&) = delete;
+
+    // Random symmetry from a seed: transposition, band and stack orders,
+    // row and column orders within them, and a digit relabeling
+    static void shuffleSymmetry(Racer& racer, uint64_t seed) {
+        for (int i = 0; i < N; i++) racer.rows[i] = racer.cols[i] = i;
+        for (int d = 0; d <= N; d++) racer.digits[d] = d;
+        racer.transpose = false;
+        if (seed == 0) return;
+
+        mt19937_64 rng(seed);
+        racer.transpose = rng() & 1;
+        int* orders[2] = {racer.rows, racer.cols};
+        for (int axis = 0; axis < 2; axis++) {
+            int bands[BoxSize];
+            for (int b = 0; b < BoxSize; b++) bands[b] = b;
+            shuffle(bands, bands + BoxSize, rng);
+            for (int b = 0; b < BoxSize; b++) {
+                int within[BoxSize];
+                for (int i = 0; i < BoxSize; i++) within[i] = i;
+                shuffle(within, within + BoxSize, rng);
+                for (int i = 0; i < BoxSize; i++) orders[axis][b * BoxSize + i] = bands[b] * BoxSize + within[i];
+            }
+        }
+        shuffle(racer.digits + 1, racer.digits + N + 1, rng);
+    }
+
+    // Worker loop of racer `index`: wait for a puzzle, race, report
+    void race(int index) {
+        Racer& racer = *racers_[index];
+        uint64_t seen = 0;
+        unique_lock<mutex> guard(lock_);
+        while (true) {
+            start_.wait(guard, [&]() { return shutdown_ || round_ != seen; });
+            if (shutdown_) return;
+            seen = round_;
+            Grid grid;
+            racer.toRacer(puzzle_, grid);
+            SolveLimits limits = limits_;
+            limits.token = &race_;
+            guard.unlock();
+
+            racer.solver.setBoard(grid);
+            SolveStatus status = racer.solver.solveWithLimits(racer.solve, limits);
+
+            guard.lock();
+            if (winner_ < 0 && (status == SOLVE_SOLVED || status == SOLVE_UNSOLVABLE)) {
+                winner_ = index;
+                status_ = status;
+                racer.wins++;
+                if (status == SOLVE_SOLVED) racer.fromRacer(racer.solver.getGrid(), solution_);
+                race_.cancel();
+            }
+            if (--running_ == 0) finished_.notify_all();
+        }
+    }
+
+public:
+    // Outcome of one race
+    struct Result {
+        SolveStatus status;
+        int winner;                          // racer that settled the puzzle, -1 if none did
+        uint64_t nodes;                      // search nodes of the winner
+        uint64_t totalNodes;                 // search nodes of every racer
+        double milliseconds;
+        Grid solution;                       // when solved
+    };
+
+    explicit PortfolioSolver(const vector<PortfolioEntry>& entries)
+        : round_(0), running_(0), shutdown_(false), winner_(-1), status_(SOLVE_UNSOLVABLE) {
+        for (size_t i = 0; i < entries.size(); i++) {
+            unique_ptr<Racer> racer(new Racer());
+            racer->entry = entries[i];
+            racer->solve = solverEngine<BoxSize>(entries[i].engineId);
+            racer->wins = 0;
+            shuffleSymmetry(*racer, entries[i].seed);
+            racers_.push_back(move(racer));
+        }
+        for (size_t i = 0; i < racers_.size(); i++) {
+            racers_[i]->worker = thread(&PortfolioSolver::race, this, (int)i);
+        }
+    }
+
+    ~PortfolioSolver() {
+        {
+            lock_guard<mutex> guard(lock_);
+            shutdown_ = true;
+        }
+        start_.notify_all();
+        for (size_t i = 0; i < racers_.size(); i++) {
+            racers_[i]->worker.join();
+        }
+    }
+
+    // Inference rules of the bitmask racers
+    void setInferenceRules(unsigned rules) {
+        for (size_t i = 0; i < racers_.size(); i++) racers_[i]->solver.setInferenceRules(rules);
+    }
+
+    // Race every racer on a puzzle. The deadline and node budget of `limits`
+    // apply to each racer; its token, when set, cancels the whole race.
+    // Returns once every racer has stopped.
+    Result solve(const Grid& puzzle, const SolveLimits& limits = SolveLimits()) {
+        auto start = chrono::steady_clock::now();
+        unique_lock<mutex> guard(lock_);
+        puzzle_ = puzzle;
+        limits_ = limits;
+        race_.reset();
+        race_.link(limits.token);
+        winner_ = -1;
+        running_ = racers_.size();
+        round_++;
+        start_.notify_all();
+        finished_.wait(guard, [&]() { return running_ == 0; });
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+        Result result;
+        result.winner = winner_;
+        result.status = winner_ >= 0 ? status_
+                      : limits.token && limits.token->isCancelled() ? SOLVE_CANCELLED : SOLVE_TIMED_OUT;
+        result.nodes = winner_ >= 0 ? racers_[winner_]->solver.getNodeCount() : 0;
+        result.totalNodes = 0;
+        for (size_t i = 0; i < racers_.size(); i++) result.totalNodes += racers_[i]->solver.getNodeCount();
+        result.milliseconds = elapsed.count();
+        if (result.status == SOLVE_SOLVED) {
+            result.solution = solution_;
+        } else {
+            result.solution = puzzle;
+        }
+        return result;
+    }
+
+    size_t size() const {
+        return racers_.size();
+    }
+
+    const PortfolioEntry& entry(int racer) const {
+        return racers_[racer]->entry;
+    }
+
+    // Races won so far by a racer
+    uint64_t wins(int racer) const {
+        return racers_[racer]->wins;
+    }
+
+    // A racer's solver, for the search counters of its last run; only read
+    // it between races
+    const Solver& solver(int racer) const {
+        return racers_[racer]->solver;
+    }
+
+    // Inference rule firings of every racer
+    RuleCounters getRuleCounters() const {
+        RuleCounters counters;
+        for (size_t i = 0; i < racers_.size(); i++) counters.add(racers_[i]->solver.getRuleCounters());
+        return counters;
+    }
+};
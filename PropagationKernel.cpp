@@ -0,0 +1,229 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Geometry.cpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SUDOKU_X86_KERNELS 1
+#endif
+
+using namespace std;
+
+// Candidate grid for the propagation kernels: one candidate mask per cell,
+// padded to a multiple of 16 lanes (81 -> 96 on a 9x9 grid, so it loads as
+// 12 SSE or 6 AVX2 registers). Filled cells and padding lanes hold 0;
+// `open` has one bit per still-empty cell.
+template <int BoxSize>
+struct BasicCandidateGrid {
+    typedef GridShape<BoxSize> Shape;
+    typedef typename Shape::Mask Mask;
+
+    static constexpr int LANES = (Shape::CELLS + 15) / 16 * 16;
+    static constexpr int WORDS = (Shape::CELLS + 63) / 64;
+
+    alignas(32) Mask cells[LANES];
+    uint64_t open[WORDS];
+
+    bool isOpen(int cell) const {
+        return (open[cell >> 6] >> (cell & 63)) & 1;
+    }
+
+    void close(int cell) {
+        open[cell >> 6] &= ~(1ull << (cell & 63));
+    }
+};
+
+typedef BasicCandidateGrid<3> CandidateGrid;
+
+// Per-cell elimination masks for the 9x9 vector kernels: 0xFFFF on the lanes
+// of the cell itself and its 20 peers, 0 elsewhere, so placing a digit clears
+// it from a whole row, column and box with one AND-NOT per register
+struct PeerLaneTable {
+    alignas(32) uint16_t lanes[81][96];
+};
+
+constexpr PeerLaneTable makePeerLaneTable() {
+    PeerLaneTable table{};
+    for (int cell = 0; cell < 81; cell++) {
+        table.lanes[cell][cell] = 0xFFFF;
+        for (int p = 0; p < GridShape<3>::PEERS; p++) {
+            table.lanes[cell][geometry<3>.peers[cell][p]] = 0xFFFF;
+        }
+    }
+    return table;
+}
+
+constexpr PeerLaneTable peerLanes = makePeerLaneTable();
+
+// Scalar kernel for every grid size: fill naked singles cell by cell until
+// none are left. Returns false once an open cell runs out of candidates.
+template <int BoxSize>
+bool propagateScalar(BasicCandidateGrid<BoxSize>& grid, uint8_t* board) {
+    typedef GridShape<BoxSize> Shape;
+    typedef typename Shape::Mask Mask;
+    const GeometryTables<BoxSize>& tables = geometry<BoxSize>;
+
+    for (;;) {
+        bool placed = false;
+        for (int cell = 0; cell < Shape::CELLS; cell++) {
+            if (!grid.isOpen(cell)) continue;
+            Mask mask = grid.cells[cell];
+            if (mask == 0) return false;
+            if ((mask & (mask - 1)) == 0) {
+                board[cell] = __builtin_ctz(mask) + 1;
+                grid.close(cell);
+                grid.cells[cell] = 0;
+                for (int p = 0; p < Shape::PEERS; p++) {
+                    grid.cells[tables.peers[cell][p]] &= ~mask;
+                }
+                placed = true;
+            }
+        }
+        if (!placed) return true;
+    }
+}
+
+#ifdef SUDOKU_X86_KERNELS
+
+// SSE2: 12 registers of 8 lanes
+inline bool propagateSSE2(CandidateGrid& grid, uint8_t* board) {
+    const PeerLaneTable& table = peerLanes;
+    __m128i* cells = reinterpret_cast<__m128i*>(grid.cells);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+
+    for (;;) {
+        // Lane flags, two registers at a time packed into 16 bits
+        uint64_t singles[2] = {0, 0}, empty[2] = {0, 0};
+        for (int k = 0; k < 12; k += 2) {
+            __m128i a = _mm_load_si128(cells + k), b = _mm_load_si128(cells + k + 1);
+            __m128i zeroA = _mm_cmpeq_epi16(a, zero), zeroB = _mm_cmpeq_epi16(b, zero);
+            __m128i powA = _mm_cmpeq_epi16(_mm_and_si128(a, _mm_sub_epi16(a, one)), zero);
+            __m128i powB = _mm_cmpeq_epi16(_mm_and_si128(b, _mm_sub_epi16(b, one)), zero);
+            uint64_t zeroBits = (uint16_t)_mm_movemask_epi8(_mm_packs_epi16(zeroA, zeroB));
+            uint64_t powBits = (uint16_t)_mm_movemask_epi8(_mm_packs_epi16(powA, powB));
+            int lane = k * 8;
+            empty[lane >> 6] |= zeroBits << (lane & 63);
+            singles[lane >> 6] |= (powBits & ~zeroBits) << (lane & 63);
+        }
+
+        if ((empty[0] & grid.open[0]) | (empty[1] & grid.open[1])) return false;
+        if ((singles[0] | singles[1]) == 0) return true;
+
+        // Place the singles in scan order. A single can lose its digit to an
+        // earlier placement in the same pass, which is a contradiction.
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = singles[word]; bits != 0; bits &= bits - 1) {
+                int cell = word * 64 + __builtin_ctzll(bits);
+                uint16_t mask = grid.cells[cell];
+                if (mask == 0) return false;
+                board[cell] = __builtin_ctz(mask) + 1;
+                grid.close(cell);
+
+                const __m128i* peers = reinterpret_cast<const __m128i*>(table.lanes[cell]);
+                __m128i digit = _mm_set1_epi16(mask);
+                for (int k = 0; k < 12; k++) {
+                    __m128i clear = _mm_and_si128(_mm_load_si128(peers + k), digit);
+                    _mm_store_si128(cells + k, _mm_andnot_si128(clear, _mm_load_si128(cells + k)));
+                }
+            }
+        }
+    }
+}
+
+// AVX2: 6 registers of 16 lanes
+__attribute__((target("avx2")))
+inline bool propagateAVX2(CandidateGrid& grid, uint8_t* board) {
+    const PeerLaneTable& table = peerLanes;
+    __m256i* cells = reinterpret_cast<__m256i*>(grid.cells);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(1);
+
+    for (;;) {
+        // packs works per 128-bit half, so restore lane order before movemask
+        uint64_t singles[2] = {0, 0}, empty[2] = {0, 0};
+        for (int k = 0; k < 6; k += 2) {
+            __m256i a = _mm256_load_si256(cells + k), b = _mm256_load_si256(cells + k + 1);
+            __m256i zeroA = _mm256_cmpeq_epi16(a, zero), zeroB = _mm256_cmpeq_epi16(b, zero);
+            __m256i powA = _mm256_cmpeq_epi16(_mm256_and_si256(a, _mm256_sub_epi16(a, one)), zero);
+            __m256i powB = _mm256_cmpeq_epi16(_mm256_and_si256(b, _mm256_sub_epi16(b, one)), zero);
+            __m256i zeroPacked = _mm256_permute4x64_epi64(_mm256_packs_epi16(zeroA, zeroB), 0xD8);
+            __m256i powPacked = _mm256_permute4x64_epi64(_mm256_packs_epi16(powA, powB), 0xD8);
+            uint64_t zeroBits = (uint32_t)_mm256_movemask_epi8(zeroPacked);
+            uint64_t powBits = (uint32_t)_mm256_movemask_epi8(powPacked);
+            int lane = k * 16;
+            empty[lane >> 6] |= zeroBits << (lane & 63);
+            singles[lane >> 6] |= (powBits & ~zeroBits) << (lane & 63);
+        }
+
+        if ((empty[0] & grid.open[0]) | (empty[1] & grid.open[1])) return false;
+        if ((singles[0] | singles[1]) == 0) return true;
+
+        // Place the singles in scan order. A single can lose its digit to an
+        // earlier placement in the same pass, which is a contradiction.
+        for (int word = 0; word < 2; word++) {
+            for (uint64_t bits = singles[word]; bits != 0; bits &= bits - 1) {
+                int cell = word * 64 + __builtin_ctzll(bits);
+                uint16_t mask = grid.cells[cell];
+                if (mask == 0) return false;
+                board[cell] = __builtin_ctz(mask) + 1;
+                grid.close(cell);
+
+                const __m256i* peers = reinterpret_cast<const __m256i*>(table.lanes[cell]);
+                __m256i digit = _mm256_set1_epi16(mask);
+                for (int k = 0; k < 6; k++) {
+                    __m256i clear = _mm256_and_si256(_mm256_load_si256(peers + k), digit);
+                    _mm256_store_si256(cells + k, _mm256_andnot_si256(clear, _mm256_load_si256(cells + k)));
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+// Propagation kernel chosen once per process and grid size
+template <int BoxSize>
+struct PropagationKernel {
+    const char* name;
+    bool (*propagate)(BasicCandidateGrid<BoxSize>& grid, uint8_t* board);
+};
+
+// Larger grids use the scalar kernel
+template <int BoxSize>
+inline PropagationKernel<BoxSize> selectPropagationKernel() {
+    PropagationKernel<BoxSize> scalar = {"scalar", &propagateScalar<BoxSize>};
+    return scalar;
+}
+
+// 9x9: pick the widest kernel the CPU supports. SUDOKU_KERNEL=scalar|sse2|avx2
+// forces a narrower one so every path can be exercised on one machine.
+template <>
+inline PropagationKernel<3> selectPropagationKernel<3>() {
+    PropagationKernel<3> scalar = {"scalar", &propagateScalar<3>};
+    const char* forced = getenv("SUDOKU_KERNEL");
+    string request = forced ? forced : "";
+    if (request == "scalar") return scalar;
+
+#ifdef SUDOKU_X86_KERNELS
+    __builtin_cpu_init();
+    PropagationKernel<3> sse2 = {"sse2", &propagateSSE2};
+    PropagationKernel<3> avx2 = {"avx2", &propagateAVX2};
+    bool hasAVX2 = __builtin_cpu_supports("avx2");
+    bool hasSSE2 = __builtin_cpu_supports("sse2");
+    if (request == "sse2") return hasSSE2 ? sse2 : scalar;
+    if (hasAVX2) return avx2;
+    if (hasSSE2) return sse2;
+#endif
+
+    return scalar;
+}
+
+template <int BoxSize>
+inline const PropagationKernel<BoxSize>& propagationKernel() {
+    static const PropagationKernel<BoxSize> kernel = selectPropagationKernel<BoxSize>();
+    return kernel;
+}
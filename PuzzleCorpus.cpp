@@ -0,0 +1,415 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define SUDOKU_MMAP 1
+#endif
+
+using namespace std;
+
+// Value of a digit symbol (1-9, then A-P for the larger grids), 0 if none
+inline int symbolValue(char ch) {
+    if (ch >= '1' && ch <= '9') return ch - '0';
+    if (ch >= 'A' && ch <= 'P') return ch - 'A' + 10;
+    if (ch >= 'a' && ch <= 'p') return ch - 'a' + 10;
+    return 0;
+}
+
+// Parse one puzzle in the common one-line format: 81 characters on a 9x9
+// grid (256 or 625 on the larger ones), digit symbols for givens and '0' or
+// '.' for empty cells. Anything after the last cell must be separated by
+// whitespace, ',' or ';' (ratings, comments, solutions).
+template <int BoxSize>
+bool parsePuzzleLine(const char* line, size_t length, BasicGrid<BoxSize>& grid) {
+    const int cells = GridShape<BoxSize>::CELLS;
+    if (length < (size_t)cells) return false;
+    if (length > (size_t)cells) {
+        char next = line[cells];
+        if (next != ' ' && next != '\t' && next != ',' && next != ';' && next != '\r') return false;
+    }
+    for (int cell = 0; cell < cells; cell++) {
+        char ch = line[cell];
+        int value = symbolValue(ch);
+        if (value >= 1 && value <= GridShape<BoxSize>::N) {
+            grid[cell] = value;
+        } else if (ch == '0' || ch == '.') {
+            grid[cell] = 0;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool parsePuzzleLine(const char* line, size_t length, Grid& grid) {
+    return parsePuzzleLine<3>(line, length, grid);
+}
+
+// Format a board back into the one-line format
+template <int BoxSize>
+string formatPuzzleLine(const BasicGrid<BoxSize>& grid) {
+    string line(grid.size(), '0');
+    for (size_t cell = 0; cell < grid.size(); cell++) {
+        if (grid[cell] != 0) line[cell] = DIGIT_SYMBOLS[grid[cell] - 1];
+    }
+    return line;
+}
+
+inline string formatPuzzleLine(const Grid& grid) {
+    return formatPuzzleLine<3>(grid);
+}
+
+// Binary puzzle format: a 24-byte header followed by fixed-size records,
+// one per puzzle, so puzzle i starts at 24 + i * recordBytes.
+//
+//   0  "SDKB"   magic
+//   4  u8       version (1)
+//   5  u8       box size (3, 4 or 5)
+//   6  u8       bits per cell (4 on 9x9, 5 on the larger grids)
+//   7  u8       reserved (0)
+//   8  u32      record bytes
+//   12 u32      reserved (0)
+//   16 u64      record count
+//
+// Integers are little-endian. Cells are packed in row-major order from the
+// low bits up, 0 for an empty cell: 41 bytes per 9x9 puzzle. Solution files
+// use the same format, with an all-empty record for a puzzle that was not
+// solved.
+const char BINARY_MAGIC[4] = {'S', 'D', 'K', 'B'};
+const size_t BINARY_HEADER_BYTES = 24;
+
+template <int BoxSize>
+struct PackedRecord {
+    static constexpr int CELLS = GridShape<BoxSize>::CELLS;
+    static constexpr int BITS = GridShape<BoxSize>::N < 16 ? 4 : 5;
+    static constexpr size_t BYTES = (CELLS * BITS + 7) / 8;
+
+    static void pack(const uint8_t* cells, uint8_t* record) {
+        memset(record, 0, BYTES);
+        for (int cell = 0; cell < CELLS; cell++) {
+            size_t bit = (size_t)cell * BITS;
+            unsigned value = (unsigned)cells[cell] << (bit & 7);
+            record[bit >> 3] |= (uint8_t)value;
+            if ((bit & 7) + BITS > 8) record[(bit >> 3) + 1] |= (uint8_t)(value >> 8);
+        }
+    }
+
+    static void unpack(const uint8_t* record, uint8_t* cells) {
+        for (int cell = 0; cell < CELLS; cell++) {
+            size_t bit = (size_t)cell * BITS;
+            unsigned value = record[bit >> 3];
+            if ((bit & 7) + BITS > 8) value |= (unsigned)record[(bit >> 3) + 1] << 8;
+            cells[cell] = (value >> (bit & 7)) & ((1u << BITS) - 1);
+        }
+    }
+};
+
+inline size_t packedRecordBytes(int boxSize) {
+    switch (boxSize) {
+        case 3: return PackedRecord<3>::BYTES;
+        case 4: return PackedRecord<4>::BYTES;
+        case 5: return PackedRecord<5>::BYTES;
+        default: return 0;
+    }
+}
+
+// Read-only view of a whole file: memory-mapped where the OS allows it,
+// read into memory otherwise
+class MappedFile {
+private:
+    const char* data_;
+    size_t size_;
+    vector<char> buffer_;                    // fallback when mmap is unavailable
+    bool mapped_;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+    MappedFile() : data_(nullptr), size_(0), mapped_(false) {}
+
+    ~MappedFile() {
+#ifdef SUDOKU_MMAP
+        if (mapped_) munmap((void*)data_, size_);
+#endif
+    }
+
+    bool open(const string& path) {
+#ifdef SUDOKU_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                madvise(map, info.st_size, MADV_SEQUENTIAL);
+                data_ = (const char*)map;
+                size_ = info.st_size;
+                mapped_ = true;
+            }
+        }
+        close(fd);
+        if (mapped_) return true;
+#endif
+        ifstream input(path.c_str(), ios::binary);
+        if (!input) return false;
+        buffer_.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return true;
+    }
+
+    const char* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+};
+
+// Puzzles of a text or binary puzzle file, read in place. Text files are
+// indexed once (one span per puzzle line, blank lines and '#' comments
+// skipped) and each line is parsed only when asked for; binary records are
+// reached directly by index.
+class PuzzleCorpus {
+private:
+    struct LineSpan {
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    MappedFile file_;
+    const char* data_;
+    size_t size_;
+    bool binary_;
+    int boxSize_;                            // of a binary file
+    size_t recordBytes_;
+    size_t count_;
+    vector<LineSpan> lines_;
+
+    void indexLines() {
+        lines_.clear();
+        size_t pos = 0;
+        while (pos < size_) {
+            const char* end = (const char*)memchr(data_ + pos, '\n', size_ - pos);
+            size_t next = end ? end - data_ : size_;
+
+            size_t start = pos;
+            while (start < next && (data_[start] == ' ' || data_[start] == '\t' || data_[start] == '\r')) start++;
+            if (start < next && data_[start] != '#') {
+                LineSpan span = {start, (uint32_t)(next - start)};
+                lines_.push_back(span);
+            }
+            pos = next + 1;
+        }
+        count_ = lines_.size();
+    }
+
+    // Check a binary header; false for a text file
+    bool readHeader(string& error) {
+        if (size_ < BINARY_HEADER_BYTES || memcmp(data_, BINARY_MAGIC, 4) != 0) return false;
+        const uint8_t* header = (const uint8_t*)data_;
+        boxSize_ = header[5];
+        recordBytes_ = header[8] | header[9] << 8 | header[10] << 16 | (size_t)header[11] << 24;
+        count_ = 0;
+        for (int b = 7; b >= 0; b--) count_ = count_ << 8 | header[16 + b];
+
+        if (header[4] != 1 || packedRecordBytes(boxSize_) == 0 || recordBytes_ != packedRecordBytes(boxSize_)) {
+            error = "unsupported binary puzzle file";
+        } else if ((size_ - BINARY_HEADER_BYTES) / recordBytes_ < count_) {
+            error = "truncated binary puzzle file";
+        }
+        return true;
+    }
+
+public:
+    PuzzleCorpus()
+        : data_(nullptr), size_(0), binary_(false), boxSize_(0), recordBytes_(0), count_(0) {}
+
+    // Map a puzzle file; text or binary is told apart by the magic bytes
+    bool openFile(const string& path) {
+        if (!file_.open(path)) {
+            cerr << "Cannot open input file: " << path << "\n";
+            return false;
+        }
+        data_ = file_.data();
+        size_ = file_.size();
+
+        string error;
+        binary_ = readHeader(error);
+        if (!error.empty()) {
+            cerr << path << ": " << error << "\n";
+            return false;
+        }
+        if (!binary_) indexLines();
+        return true;
+    }
+
+    // View text puzzles held in memory (the buffer must outlive the corpus)
+    void openText(const char* data, size_t size) {
+        data_ = data;
+        size_ = size;
+        binary_ = false;
+        indexLines();
+    }
+
+    // View puzzles [begin, end) of another corpus, which must outlive this
+    // one; puzzle 0 here is puzzle `begin` there
+    void openSlice(const PuzzleCorpus& corpus, size_t begin, size_t end) {
+        data_ = corpus.data_;
+        size_ = corpus.size_;
+        binary_ = corpus.binary_;
+        boxSize_ = corpus.boxSize_;
+        recordBytes_ = corpus.recordBytes_;
+        count_ = end - begin;
+        if (binary_) {
+            data_ += begin * recordBytes_;
+            lines_.clear();
+        } else {
+            lines_.assign(corpus.lines_.begin() + begin, corpus.lines_.begin() + end);
+        }
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    bool isBinary() const {
+        return binary_;
+    }
+
+    // Box size of a binary file, 0 for text
+    int boxSize() const {
+        return binary_ ? boxSize_ : 0;
+    }
+
+    // Puzzle i; false if its line does not parse, a record holds a cell
+    // value above N, or the grid size differs
+    template <int BoxSize>
+    bool puzzle(size_t i, BasicGrid<BoxSize>& grid) const {
+        if (binary_) {
+            if (boxSize_ != BoxSize) return false;
+            const uint8_t* record = (const uint8_t*)data_ + BINARY_HEADER_BYTES + i * recordBytes_;
+            PackedRecord<BoxSize>::unpack(record, grid.data());
+            for (int cell = 0; cell < GridShape<BoxSize>::CELLS; cell++) {
+                if (grid[cell] > GridShape<BoxSize>::N) return false;
+            }
+            return true;
+        }
+        return parsePuzzleLine<BoxSize>(data_ + lines_[i].offset, lines_[i].length, grid);
+    }
+};
+
+// Buffered writer for the binary format; the record count is fixed up front
+template <int BoxSize>
+class BinaryPuzzleWriter {
+private:
+    ofstream out_;
+
+public:
+    bool open(const string& path, uint64_t count) {
+        out_.open(path.c_str(), ios::binary);
+        if (!out_) return false;
+
+        uint8_t header[BINARY_HEADER_BYTES] = {0};
+        memcpy(header, BINARY_MAGIC, 4);
+        header[4] = 1;
+        header[5] = BoxSize;
+        header[6] = PackedRecord<BoxSize>::BITS;
+        size_t recordBytes = PackedRecord<BoxSize>::BYTES;
+        for (int b = 0; b < 4; b++) header[8 + b] = (uint8_t)(recordBytes >> (8 * b));
+        for (int b = 0; b < 8; b++) header[16 + b] = (uint8_t)(count >> (8 * b));
+        out_.write((const char*)header, sizeof(header));
+        return (bool)out_;
+    }
+
+    void write(const BasicGrid<BoxSize>& grid) {
+        uint8_t record[PackedRecord<BoxSize>::BYTES];
+        PackedRecord<BoxSize>::pack(grid.data(), record);
+        out_.write((const char*)record, sizeof(record));
+    }
+
+    // Records packed elsewhere, e.g. by a shard of a sharded run
+    void writePacked(const char* records, size_t bytes) {
+        out_.write(records, bytes);
+    }
+
+    bool close() {
+        out_.close();
+        return !out_.fail();
+    }
+};
+
+// Convert a puzzle file between text and binary; the direction follows the
+// input. Text lines that do not parse are skipped and counted.
+template <int BoxSize>
+bool convertCorpusOfSize(const string& inputPath, const string& outputPath) {
+    PuzzleCorpus corpus;
+    if (!corpus.openFile(inputPath)) return false;
+
+    BasicGrid<BoxSize> grid;
+    if (corpus.isBinary()) {
+        if (corpus.boxSize() != BoxSize) {
+            cerr << inputPath << ": grid size does not match --size\n";
+            return false;
+        }
+        ofstream out(outputPath.c_str());
+        if (!out) {
+            cerr << "Cannot open output file: " << outputPath << "\n";
+            return false;
+        }
+        // A damaged record keeps its line, as 'invalid', so lines still
+        // match records
+        size_t damaged = 0;
+        for (size_t i = 0; i < corpus.size(); i++) {
+            if (corpus.puzzle<BoxSize>(i, grid)) {
+                out << formatPuzzleLine<BoxSize>(grid) << "\n";
+            } else {
+                out << "invalid\n";
+                damaged++;
+            }
+        }
+        cerr << "Converted " << corpus.size() << " puzzles to text";
+        if (damaged > 0) cerr << " (" << damaged << " damaged records written as 'invalid')";
+        cerr << "\n";
+        return (bool)out;
+    }
+
+    size_t valid = 0;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        if (corpus.puzzle<BoxSize>(i, grid)) valid++;
+    }
+
+    BinaryPuzzleWriter<BoxSize> writer;
+    if (!writer.open(outputPath, valid)) {
+        cerr << "Cannot open output file: " << outputPath << "\n";
+        return false;
+    }
+    for (size_t i = 0; i < corpus.size(); i++) {
+        if (corpus.puzzle<BoxSize>(i, grid)) writer.write(grid);
+    }
+    cerr << "Converted " << valid << " puzzles to binary";
+    if (valid < corpus.size()) cerr << " (skipped " << corpus.size() - valid << " unreadable lines)";
+    cerr << "\n";
+    return writer.close();
+}
+
+inline bool convertCorpus(const string& inputPath, const string& outputPath, int boxSize) {
+    switch (boxSize) {
+        case 3: return convertCorpusOfSize<3>(inputPath, outputPath);
+        case 4: return convertCorpusOfSize<4>(inputPath, outputPath);
+        case 5: return convertCorpusOfSize<5>(inputPath, outputPath);
+        default: return false;
+    }
+}
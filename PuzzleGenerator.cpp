@@ -0,0 +1,247 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include "PuzzleCorpus.cpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+// Difficulty bands, rated by what the bitmask engine needs to solve a puzzle
+enum PuzzleDifficulty {
+    DIFFICULTY_ANY,
+    DIFFICULTY_EASY,                         // naked and hidden singles alone
+    DIFFICULTY_MEDIUM,                       // also pairs, pointing or box-line, no guessing
+    DIFFICULTY_HARD                          // needs search even with every rule
+};
+
+const char* const DIFFICULTY_NAMES[] = {"any", "easy", "medium", "hard"};
+
+inline bool parseDifficulty(const string& name, PuzzleDifficulty& difficulty) {
+    for (int d = DIFFICULTY_ANY; d <= DIFFICULTY_HARD; d++) {
+        if (name == DIFFICULTY_NAMES[d]) {
+            difficulty = (PuzzleDifficulty)d;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Generator run configuration
+struct GeneratorOptions {
+    size_t count = 1000;
+    string outputPath;                       // empty for standard output
+    int threads = 0;                         // 0 for one per hardware thread
+    uint64_t seed = 1;                       // same seed and threads, same puzzles
+    int targetClues = 0;                     // stop removing clues here, 0 for minimal puzzles
+    PuzzleDifficulty difficulty = DIFFICULTY_ANY;
+    int maxAttempts = 1000;                  // grids tried per puzzle before giving up
+};
+
+// Totals reported at the end of a generator run
+struct GeneratorStats {
+    size_t generated = 0;
+    size_t failed = 0;                       // slots left empty after maxAttempts
+    uint64_t attempts = 0;                   // grids dug, rejected ones included
+    uint64_t clues = 0;                      // summed over generated puzzles
+    size_t byDifficulty[4] = {0, 0, 0, 0};
+    int threads = 0;
+    double seconds = 0;
+};
+
+// One worker's generator: its own solver and RNG stream
+class PuzzleGenerator {
+private:
+    SudokuSolver solver_;
+    mt19937_64 rng_;
+
+public:
+    PuzzleGenerator(uint64_t seed, uint64_t stream) {
+        seed_seq sequence = {(uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)stream, (uint32_t)(stream >> 32)};
+        rng_.seed(sequence);
+    }
+
+    // Random complete grid: the three diagonal boxes are independent, so
+    // they are filled with random permutations and the solver completes the
+    // rest; a random symmetry then scatters the solver's fixed fill order
+    void fillGrid(Grid& grid) {
+        do {
+            grid.fill(0);
+            for (int box = 0; box < 3; box++) {
+                uint8_t digits[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+                shuffle(digits, digits + 9, rng_);
+                for (int i = 0; i < 9; i++) {
+                    grid[(box * 3 + i / 3) * 9 + box * 3 + i % 3] = digits[i];
+                }
+            }
+            solver_.setBoard(grid);
+        } while (!solver_.solveBitmask());
+
+        BoardTransform transform;
+        transform.transpose = rng_() & 1;
+        uint8_t bands[3] = {0, 1, 2}, stacks[3] = {0, 1, 2};
+        shuffle(bands, bands + 3, rng_);
+        shuffle(stacks, stacks + 3, rng_);
+        for (int i = 0; i < 3; i++) {
+            uint8_t rows[3] = {0, 1, 2}, cols[3] = {0, 1, 2};
+            shuffle(rows, rows + 3, rng_);
+            shuffle(cols, cols + 3, rng_);
+            for (int j = 0; j < 3; j++) {
+                transform.rows[i * 3 + j] = bands[i] * 3 + rows[j];
+                transform.cols[i * 3 + j] = stacks[i] * 3 + cols[j];
+            }
+        }
+        transform.digits[0] = 0;
+        for (int d = 1; d <= 9; d++) transform.digits[d] = d;
+        shuffle(transform.digits + 1, transform.digits + 10, rng_);
+        transform.apply(solver_.getGrid().data(), grid.data());
+    }
+
+    // Remove clues in random order, putting back any whose removal lets a
+    // second solution in (one with another digit in the cleared cell).
+    // Stops at targetClues; with 0 it tries every cell, which leaves a
+    // minimal puzzle (a clue needed once stays needed as the puzzle loses
+    // more). Returns the clue count.
+    int digClues(const Grid& solution, Grid& puzzle, int targetClues) {
+        puzzle = solution;
+        // Naked singles only: on these mostly shallow checks the extra rules
+        // cost more per node than the search they save
+        solver_.setInferenceRules(0);
+        uint8_t order[81];
+        for (int cell = 0; cell < 81; cell++) order[cell] = cell;
+        shuffle(order, order + 81, rng_);
+
+        int clues = 81;
+        for (int i = 0; i < 81 && clues > targetClues; i++) {
+            int cell = order[i];
+            puzzle[cell] = 0;
+            solver_.setBoard(puzzle);
+            if (!solver_.hasSolutionAvoiding(cell, solution[cell])) {
+                clues--;
+            } else {
+                puzzle[cell] = solution[cell];
+            }
+        }
+        return clues;
+    }
+
+    // Difficulty band of a puzzle with a unique solution
+    PuzzleDifficulty rate(const Grid& puzzle) {
+        const unsigned singles = 1u << RULE_HIDDEN_SINGLES;
+        const unsigned levels[2] = {singles, ALL_INFERENCE_RULES};
+        for (int level = 0; level < 2; level++) {
+            solver_.setInferenceRules(levels[level]);
+            solver_.setBoard(puzzle);
+            solver_.solveBitmask();
+            if (solver_.getNodeCount() == 1) {
+                return level == 0 ? DIFFICULTY_EASY : DIFFICULTY_MEDIUM;
+            }
+        }
+        return DIFFICULTY_HARD;
+    }
+
+    // Generate one puzzle meeting the options; false after maxAttempts grids
+    bool generate(const GeneratorOptions& options, Grid& puzzle, PuzzleDifficulty& difficulty,
+                  uint64_t& attempts) {
+        Grid solution;
+        for (int attempt = 0; attempt < options.maxAttempts; attempt++) {
+            attempts++;
+            fillGrid(solution);
+            int clues = digClues(solution, puzzle, options.targetClues);
+            if (options.targetClues > 0 && clues != options.targetClues) continue;
+            difficulty = rate(puzzle);
+            if (options.difficulty == DIFFICULTY_ANY || difficulty == options.difficulty) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Generate options.count puzzles on all cores and write them one per line in
+// the batch input format. Worker w fills slots w, w + threads, ... from its
+// own RNG stream, so a seed and thread count always give the same file.
+bool runGenerator(const GeneratorOptions& options, GeneratorStats& stats) {
+    int threads = options.threads > 0 ? options.threads : (int)thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+
+    vector<Grid> puzzles(options.count);
+    vector<int8_t> difficulties(options.count, -1);
+    vector<uint64_t> attempts(threads, 0);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int w = 0; w < threads; w++) {
+        workers.push_back(thread([&, w]() {
+            PuzzleGenerator generator(options.seed, w);
+            for (size_t i = w; i < options.count; i += threads) {
+                PuzzleDifficulty difficulty;
+                if (generator.generate(options, puzzles[i], difficulty, attempts[w])) {
+                    difficulties[i] = difficulty;
+                }
+            }
+        }));
+    }
+    for (size_t w = 0; w < workers.size(); w++) {
+        workers[w].join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    ofstream file;
+    if (!options.outputPath.empty()) {
+        file.open(options.outputPath.c_str());
+        if (!file) {
+            cerr << "Cannot open output file: " << options.outputPath << "\n";
+            return false;
+        }
+    }
+    ostream& output = options.outputPath.empty() ? cout : file;
+
+    stats = GeneratorStats();
+    stats.threads = threads;
+    stats.seconds = elapsed.count();
+    for (int w = 0; w < threads; w++) {
+        stats.attempts += attempts[w];
+    }
+    for (size_t i = 0; i < options.count; i++) {
+        if (difficulties[i] < 0) {
+            stats.failed++;
+            continue;
+        }
+        stats.generated++;
+        stats.byDifficulty[difficulties[i]]++;
+        for (int cell = 0; cell < 81; cell++) stats.clues += puzzles[i][cell] != 0;
+        output << formatPuzzleLine(puzzles[i]) << "\n";
+    }
+    output.flush();
+    return true;
+}
+
+// Print the end-of-run summary
+void printGeneratorStats(const GeneratorOptions& options, const GeneratorStats& stats, ostream& out) {
+    out << "\n" << string(40, '-') << "\n";
+    out << "GENERATOR SUMMARY (" << stats.threads << " threads, seed " << options.seed << ")\n";
+    out << string(40, '-') << "\n";
+    out << "Generated:   " << stats.generated << "\n";
+    if (stats.failed > 0) {
+        out << "Failed:      " << stats.failed << " (no match in " << options.maxAttempts << " grids)\n";
+    }
+    out << "Grids dug:   " << stats.attempts << "\n";
+    if (stats.generated > 0) {
+        out << "Avg clues:   " << fixed << setprecision(1) << (double)stats.clues / stats.generated << "\n";
+    }
+    for (int d = DIFFICULTY_EASY; d <= DIFFICULTY_HARD; d++) {
+        out << "  " << left << setw(11) << DIFFICULTY_NAMES[d] << right << stats.byDifficulty[d] << "\n";
+    }
+    out << "Time:        " << fixed << setprecision(3) << stats.seconds * 1000.0 << " ms\n";
+    if (stats.seconds > 0) {
+        out << "Throughput:  " << fixed << setprecision(0) << stats.generated / stats.seconds << " puzzles/sec\n";
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Geometry.cpp"
+
+using namespace std;
+
+// Order in which a branch tries the digits of its cell
+enum ValueOrder {
+    VALUE_ORDER_ASCENDING,                   // 1, 2, 3...
+    VALUE_ORDER_LEAST_CONSTRAINING,          // the digit the fewest open peers could take first
+    VALUE_ORDER_RANDOM,                      // a random untried digit, from the seed
+    VALUE_ORDER_COUNT
+};
+
+const char* const VALUE_ORDER_NAMES[] = {"ascending", "lcv", "random"};
+
+inline bool parseValueOrder(const string& name, ValueOrder& order) {
+    for (int i = 0; i < VALUE_ORDER_COUNT; i++) {
+        if (name == VALUE_ORDER_NAMES[i]) {
+            order = (ValueOrder)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Search heuristics of the backtracking and constraint engines, against the
+// heavy tail of run times an unlucky fixed order gives on some puzzles. The
+// defaults are the plain search: ascending digits, ties in the cell choice
+// broken by scan order, no restarts, no nogoods.
+//
+// With restarts, a run that spends its node budget starts over from the
+// givens and the budget grows by restartGrowth. Every run after the first
+// breaks cell-choice ties at random, and tries digits at random unless the
+// order is lcv, so no two runs search the same tree; the growing budget
+// keeps the search complete.
+//
+// Nogoods are boards the search proved to have no completion, looked up
+// before a node is expanded. They pay off across restarts, where the same
+// dead subtrees would otherwise be searched again.
+struct SearchHeuristics {
+    ValueOrder valueOrder = VALUE_ORDER_ASCENDING;
+    uint64_t seed = 0;                       // random orders and tie-breaking
+    uint64_t restartNodes = 0;               // node budget of the first run, 0 for no restarts
+    double restartGrowth = 1.5;              // budget factor from one run to the next, above 1
+    size_t nogoods = 0;                      // dead-end boards kept, 0 for none
+
+    bool randomized() const {
+        return valueOrder == VALUE_ORDER_RANDOM || restartNodes > 0;
+    }
+};
+
+// 64-bit key per (cell, digit), XOR-ed into a running board hash as digits
+// are placed and cleared (Zobrist hashing); digit 0 keys to nothing
+template <int BoxSize>
+struct ZobristKeys {
+    uint64_t keys[GridShape<BoxSize>::CELLS][GridShape<BoxSize>::N + 1];
+};
+
+template <int BoxSize>
+constexpr ZobristKeys<BoxSize> makeZobristKeys() {
+    ZobristKeys<BoxSize> table{};
+    uint64_t state = 0x9E3779B97F4A7C15ull * BoxSize;
+    for (int cell = 0; cell < GridShape<BoxSize>::CELLS; cell++) {
+        for (int digit = 1; digit <= GridShape<BoxSize>::N; digit++) {
+            // splitmix64
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            table.keys[cell][digit] = z ^ (z >> 31);
+        }
+    }
+    return table;
+}
+
+template <int BoxSize>
+constexpr ZobristKeys<BoxSize> zobristKeys = makeZobristKeys<BoxSize>();
+
+// Bounded set of board hashes known to have no completion. Two-way buckets
+// in a power-of-two table; a full bucket drops one of its keys, so the
+// store never grows and a lookup is two loads. A dropped nogood only costs
+// searching that subtree again, and a board's hash covers every cell, so a
+// nogood stays true whichever puzzle or run reaches that board.
+class NogoodStore {
+private:
+    vector<uint64_t> slots_;                 // 0 for an empty slot
+    size_t mask_;
+    uint64_t stored_;
+    uint64_t hits_;
+
+    static uint64_t key(uint64_t hash) {
+        return hash | 1;                     // never 0
+    }
+
+public:
+    NogoodStore() : mask_(0), stored_(0), hits_(0) {}
+
+    // Make room for about `capacity` boards, dropping any stored
+    void reset(size_t capacity) {
+        size_t slots = 2;
+        while (slots < capacity) slots <<= 1;
+        slots_.assign(capacity > 0 ? slots : 0, 0);
+        mask_ = slots - 1;
+        stored_ = hits_ = 0;
+    }
+
+    size_t capacity() const {
+        return slots_.size();
+    }
+
+    bool contains(uint64_t hash) {
+        if (slots_.empty()) return false;
+        uint64_t k = key(hash);
+        size_t slot = k & mask_ & ~(size_t)1;
+        if (slots_[slot] == k || slots_[slot + 1] == k) {
+            hits_++;
+            return true;
+        }
+        return false;
+    }
+
+    void add(uint64_t hash) {
+        if (slots_.empty()) return;
+        uint64_t k = key(hash);
+        size_t slot = k & mask_ & ~(size_t)1;
+        if (slots_[slot] == k || slots_[slot + 1] == k) return;
+        if (slots_[slot] != 0 && slots_[slot + 1] == 0) {
+            slot++;
+        } else if (slots_[slot] != 0) {
+            slot += (k >> 32) & 1;           // both full: evict one by a hash bit
+        }
+        slots_[slot] = k;
+        stored_++;
+    }
+
+    // Dead ends recorded and pruned since the last reset
+    uint64_t stored() const {
+        return stored_;
+    }
+
+    uint64_t hits() const {
+        return hits_;
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+
+using namespace std;
+
+// Search instrumentation. The node count is always kept (the benchmark
+// reports nodes/sec from it); everything else is recorded only when built
+// with -DSUDOKU_STATS (make stats) and compiles away otherwise.
+#ifdef SUDOKU_STATS
+constexpr bool SEARCH_STATS_ENABLED = true;
+#else
+constexpr bool SEARCH_STATS_ENABLED = false;
+#endif
+
+// Counters of the last solve
+struct SearchStats {
+    uint64_t nodes = 0;                      // search nodes visited
+    uint64_t backtracks = 0;                 // branches undone after a dead end
+    int maxDepth = 0;                        // deepest branching level reached
+    uint64_t propagationPasses = 0;          // propagation runs to a fixpoint
+    uint64_t candidatesEliminated = 0;       // candidates removed by propagation
+    uint64_t restarts = 0;                   // runs cut off by the restart schedule
+    uint64_t nogoodPrunes = 0;               // nodes skipped as known dead ends
+    double propagationSeconds = 0;
+    double searchSeconds = 0;                // solve time outside propagation
+
+    string toJson() const {
+        ostringstream out;
+        out << "{\"nodes\": " << nodes << ", \"backtracks\": " << backtracks
+            << ", \"max_depth\": " << maxDepth << ", \"propagation_passes\": " << propagationPasses
+            << ", \"candidates_eliminated\": " << candidatesEliminated << ", \"restarts\": " << restarts
+            << ", \"nogood_prunes\": " << nogoodPrunes << fixed << setprecision(4)
+            << ", \"propagation_ms\": " << propagationSeconds * 1000.0
+            << ", \"search_ms\": " << searchSeconds * 1000.0 << "}";
+        return out.str();
+    }
+};
+
+// Stopwatch that only reads the clock when stats are compiled in
+class StatsTimer {
+private:
+    chrono::steady_clock::time_point start_;
+
+public:
+    StatsTimer() {
+        if constexpr (SEARCH_STATS_ENABLED) start_ = chrono::steady_clock::now();
+    }
+
+    double seconds() const {
+        if constexpr (SEARCH_STATS_ENABLED) {
+            return chrono::duration<double>(chrono::steady_clock::now() - start_).count();
+        }
+        return 0;
+    }
+};
@@ -0,0 +1,418 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include "BatchSolver.cpp"
+#include "PuzzleCorpus.cpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <iomanip>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#define SUDOKU_SHARDED_RUN 1
+#endif
+
+using namespace std;
+
+// Batch run split into shards of consecutive puzzles, solved by local worker
+// processes, each shard checkpointed to the work directory once done. A
+// killed or crashed run started again with the same work directory skips
+// the finished shards, so a failure costs at most the shards in flight. When
+// every shard is done, their results are merged in input order into the
+// output and their counters into one summary.
+//
+// Work directory layout:
+//   manifest              input, size, shard size and the options that
+//                         change results; a resume must match it
+//   shard-000000.stats    counters of shard 0, one line of key=value
+//   shard-000000.out      results of shard 0: text lines, or packed records
+//                         for binary input
+// Both files are written under a temporary name, flushed to disk and
+// renamed into place, .stats first, so a shard counts as done exactly when
+// its .out exists.
+struct ShardedOptions {
+    BatchOptions batch;                      // input, output, engine and limits
+    string workDir;
+    int workers = 0;                         // worker processes, 0 for one per hardware thread
+    size_t shardSize = 10000;                // puzzles per shard: the most work a kill loses per worker
+};
+
+inline string shardPath(const string& workDir, size_t shard, const char* suffix) {
+    char name[32];
+    snprintf(name, sizeof(name), "/shard-%06zu", shard);
+    return workDir + name + suffix;
+}
+
+// Counters of one shard as a line of key=value pairs
+inline string formatShardStats(const BatchStats& stats) {
+    ostringstream out;
+    out << "puzzles=" << stats.puzzles << " solved=" << stats.solved << " unsolvable=" << stats.unsolvable
+        << " invalid=" << stats.invalid << " multiple=" << stats.multiple << " timeout=" << stats.timedOut
+        << " cancelled=" << stats.cancelled << " cache_hits=" << stats.cacheHits
+        << " cache_misses=" << stats.cacheMisses << " seconds=" << stats.seconds;
+    for (int rule = 0; rule < RULE_COUNT; rule++) {
+        out << " rule:" << INFERENCE_RULE_NAMES[rule] << "=" << stats.rules.fired[rule];
+    }
+    for (int route = 0; route < ROUTE_COUNT; route++) {
+        out << " route:" << SOLVE_ROUTE_NAMES[route] << "=" << stats.routes[route];
+    }
+    out << "\n";
+    return out.str();
+}
+
+// Add the counters of a formatShardStats line to `stats`; false if the
+// line is damaged
+inline bool addShardStats(const string& line, BatchStats& stats) {
+    istringstream in(line);
+    string pair;
+    bool complete = false;
+    while (in >> pair) {
+        size_t equals = pair.find('=');
+        if (equals == string::npos) return false;
+        string key = pair.substr(0, equals);
+        string value = pair.substr(equals + 1);
+        uint64_t count = strtoull(value.c_str(), nullptr, 10);
+        if (key == "puzzles") stats.puzzles += count;
+        else if (key == "solved") stats.solved += count;
+        else if (key == "unsolvable") stats.unsolvable += count;
+        else if (key == "invalid") stats.invalid += count;
+        else if (key == "multiple") stats.multiple += count;
+        else if (key == "timeout") stats.timedOut += count;
+        else if (key == "cancelled") stats.cancelled += count;
+        else if (key == "cache_hits") stats.cacheHits += count;
+        else if (key == "cache_misses") stats.cacheMisses += count;
+        else if (key == "seconds") complete = true;
+        for (int rule = 0; rule < RULE_COUNT; rule++) {
+            if (key == string("rule:") + INFERENCE_RULE_NAMES[rule]) stats.rules.fired[rule] += count;
+        }
+        for (int route = 0; route < ROUTE_COUNT; route++) {
+            if (key == string("route:") + SOLVE_ROUTE_NAMES[route]) stats.routes[route] += count;
+        }
+    }
+    return complete;
+}
+
+// What a resumed run must agree on with the run that wrote the checkpoints
+inline string formatManifest(const ShardedOptions& options, uint64_t inputBytes, size_t puzzles) {
+    const BatchOptions& batch = options.batch;
+    ostringstream out;
+    out << "input=" << batch.inputPath << "\n"
+        << "input_bytes=" << inputBytes << "\n"
+        << "puzzles=" << puzzles << "\n"
+        << "size=" << batch.boxSize << "\n"
+        << "shard_size=" << options.shardSize << "\n"
+        << "engine=" << batch.engineId << "\n"
+        << "unique=" << batch.requireUnique << "\n"
+        << "rules=" << batch.inferenceRules << "\n"
+        << "timeout_ms=" << batch.timeoutMs << "\n"
+        << "max_nodes=" << batch.maxNodes << "\n"
+        << "value_order=" << VALUE_ORDER_NAMES[batch.heuristics.valueOrder] << "\n"
+        << "seed=" << batch.heuristics.seed << "\n"
+        << "restarts=" << batch.heuristics.restartNodes << "," << batch.heuristics.restartGrowth << "\n"
+        << "auto_thresholds=" << batch.routing.trivialOpen << "," << batch.routing.dlxBranching << "\n";
+    return out.str();
+}
+
+inline bool readWholeFile(const string& path, string& data) {
+    ifstream input(path.c_str(), ios::binary);
+    if (!input) return false;
+    ostringstream buffer;
+    buffer << input.rdbuf();
+    data = buffer.str();
+    return true;
+}
+
+#ifdef SUDOKU_SHARDED_RUN
+
+// Write a file under a temporary name, flush it to disk and rename it into
+// place, so a kill leaves either the whole file or none
+inline bool writeFileAtomically(const string& path, const string& data) {
+    string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+    bool ok = written == data.size() && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    return ok && rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+inline bool fileExists(const string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+// One worker process: claim shards off the shared counter until none are
+// left, solving each on one thread and checkpointing it. Returns the exit
+// code.
+template <int BoxSize>
+int runShardWorker(const ShardedOptions& options, const PuzzleCorpus& corpus, const vector<size_t>& pending,
+                   atomic<size_t>* next, size_t shards) {
+    const BatchOptions& batch = options.batch;
+    BasicSudokuSolver<BoxSize> solver;
+    solver.setInferenceRules(batch.inferenceRules);
+    solver.setSearchThreads(batch.searchThreads);
+    solver.setSearchHeuristics(batch.heuristics);
+    if (BoxSize == 3) solver.setAutoRouting(batch.routing);
+    unique_ptr<SolutionCache> cache;
+    if (batch.cacheSize > 0 && BoxSize == 3) cache.reset(new SolutionCache(batch.cacheSize));
+    solver.setSolutionCache(cache.get());
+
+    for (;;) {
+        size_t claimed = next->fetch_add(1);
+        if (claimed >= pending.size()) return 0;
+        size_t shard = pending[claimed];
+        size_t begin = shard * options.shardSize;
+        size_t end = min(corpus.size(), begin + options.shardSize);
+        size_t count = end - begin;
+
+        PuzzleCorpus slice;
+        slice.openSlice(corpus, begin, end);
+        vector<BasicGrid<BoxSize>> results(count);
+        vector<uint8_t> statuses(count, PUZZLE_INVALID);
+        vector<SearchStats> searchStats;
+        vector<int8_t> winners(count, -1), routes(count, -1);
+        uint64_t hitsBefore = cache ? cache->hits() : 0, missesBefore = cache ? cache->misses() : 0;
+        solver.resetRuleCounters();
+
+        auto start = chrono::steady_clock::now();
+        solveRange(solver, (PortfolioSolver<BoxSize>*)nullptr, batch, slice, 0, count,
+                   results, statuses, searchStats, winners, routes);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        BatchStats stats;
+        stats.puzzles = count;
+        stats.seconds = elapsed.count();
+        stats.rules = solver.getRuleCounters();
+        if (cache) {
+            stats.cacheHits = cache->hits() - hitsBefore;
+            stats.cacheMisses = cache->misses() - missesBefore;
+        }
+        string output;
+        BasicGrid<BoxSize> empty = {};
+        for (size_t i = 0; i < count; i++) {
+            switch (statuses[i]) {
+                case PUZZLE_SOLVED: stats.solved++; break;
+                case PUZZLE_UNSOLVABLE: stats.unsolvable++; break;
+                case PUZZLE_MULTIPLE: stats.multiple++; break;
+                case PUZZLE_TIMED_OUT: stats.timedOut++; break;
+                case PUZZLE_CANCELLED: stats.cancelled++; break;
+                default: stats.invalid++; break;
+            }
+            if (routes[i] >= 0) stats.routes[routes[i]]++;
+            if (corpus.isBinary()) {
+                uint8_t record[PackedRecord<BoxSize>::BYTES];
+                PackedRecord<BoxSize>::pack((statuses[i] == PUZZLE_SOLVED ? results[i] : empty).data(), record);
+                output.append((const char*)record, sizeof(record));
+            } else {
+                output += formatResultLine<BoxSize>(statuses[i], results[i]);
+                output += '\n';
+            }
+        }
+
+        if (!writeFileAtomically(shardPath(options.workDir, shard, ".stats"), formatShardStats(stats)) ||
+            !writeFileAtomically(shardPath(options.workDir, shard, ".out"), output)) {
+            cerr << "Cannot write shard " + to_string(shard) + " to " + options.workDir + "\n";
+            return 1;
+        }
+        ostringstream progress;
+        progress << "Shard " << shard + 1 << "/" << shards << ": " << count << " puzzles in "
+                 << fixed << setprecision(3) << elapsed.count() << " s\n";
+        cerr << progress.str();
+    }
+}
+
+template <int BoxSize>
+bool runShardedOfSize(const ShardedOptions& options, BatchStats& stats) {
+    const BatchOptions& batch = options.batch;
+    PuzzleCorpus corpus;
+    if (!corpus.openFile(batch.inputPath)) {
+        return false;
+    }
+    if (corpus.isBinary()) {
+        if (corpus.boxSize() != BoxSize) {
+            cerr << batch.inputPath << ": grid size does not match --size\n";
+            return false;
+        }
+        if (batch.outputPath.empty()) {
+            cerr << "Binary input needs --output for the binary solutions\n";
+            return false;
+        }
+    }
+    size_t count = corpus.size();
+    size_t shards = (count + options.shardSize - 1) / options.shardSize;
+
+    // Start the work directory, or check that it belongs to this run
+    struct stat input;
+    if (stat(batch.inputPath.c_str(), &input) != 0) {
+        cerr << "Cannot open input file: " << batch.inputPath << "\n";
+        return false;
+    }
+    if (mkdir(options.workDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        cerr << "Cannot create work directory: " << options.workDir << "\n";
+        return false;
+    }
+    string manifest = formatManifest(options, input.st_size, count), existing;
+    string manifestPath = options.workDir + "/manifest";
+    if (readWholeFile(manifestPath, existing)) {
+        if (existing != manifest) {
+            cerr << options.workDir << " holds checkpoints of a different run (other input or options);\n"
+                 << "remove it or pick another --workdir\n";
+            return false;
+        }
+    } else if (!writeFileAtomically(manifestPath, manifest)) {
+        cerr << "Cannot write " << manifestPath << "\n";
+        return false;
+    }
+
+    vector<size_t> pending;
+    size_t resumed = 0;
+    for (size_t shard = 0; shard < shards; shard++) {
+        if (fileExists(shardPath(options.workDir, shard, ".out"))) {
+            resumed += min(count, (shard + 1) * options.shardSize) - shard * options.shardSize;
+        } else {
+            pending.push_back(shard);
+        }
+    }
+
+    int workers = options.workers > 0 ? options.workers : (int)thread::hardware_concurrency();
+    workers = max(1, min<int>(workers, (int)pending.size()));
+    if (!pending.empty()) {
+        cerr << "Sharded run: " << shards << " shards of " << options.shardSize << " puzzles, "
+             << shards - pending.size() << " already done, " << workers << " worker processes\n";
+    }
+
+    // Workers claim shards off a counter in memory shared across fork()
+    auto start = chrono::steady_clock::now();
+    void* shared = mmap(nullptr, sizeof(atomic<size_t>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        cerr << "Cannot map the shard counter\n";
+        return false;
+    }
+    atomic<size_t>* next = new (shared) atomic<size_t>(0);
+    cout.flush();
+    cerr.flush();
+    vector<pid_t> children;
+    pid_t parent = getpid();
+    for (int w = 0; w < workers && !pending.empty(); w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+#ifdef __linux__
+            // Die with the coordinator, so a killed run leaves no workers
+            // behind to race the run that resumes it
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() != parent) _exit(1);
+#endif
+            _exit(runShardWorker<BoxSize>(options, corpus, pending, next, shards));
+        }
+        if (pid < 0) {
+            cerr << "Cannot start worker process " << w << "\n";
+            break;
+        }
+        children.push_back(pid);
+    }
+    int failed = 0;
+    for (size_t w = 0; w < children.size(); w++) {
+        int status;
+        while (waitpid(children[w], &status, 0) < 0 && errno == EINTR) {}
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+    munmap(shared, sizeof(atomic<size_t>));
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    size_t unfinished = 0;
+    for (size_t p = 0; p < pending.size(); p++) {
+        if (!fileExists(shardPath(options.workDir, pending[p], ".out"))) unfinished++;
+    }
+    if (failed > 0 || unfinished > 0) {
+        cerr << failed << " worker processes failed, " << unfinished << " of " << shards
+             << " shards unfinished; run the same command again to resume\n";
+        return false;
+    }
+
+    // Merge the shards in input order
+    stats = BatchStats();
+    stats.threads = workers;
+    stats.seconds = elapsed.count();
+    stats.resumed = resumed;
+    BinaryPuzzleWriter<BoxSize> writer;
+    ofstream file;
+    if (corpus.isBinary()) {
+        if (!writer.open(batch.outputPath, count)) {
+            cerr << "Cannot open output file: " << batch.outputPath << "\n";
+            return false;
+        }
+    } else if (!batch.outputPath.empty()) {
+        file.open(batch.outputPath.c_str(), ios::binary);
+        if (!file) {
+            cerr << "Cannot open output file: " << batch.outputPath << "\n";
+            return false;
+        }
+    }
+    ostream& output = batch.outputPath.empty() ? cout : file;
+    for (size_t shard = 0; shard < shards; shard++) {
+        string line, data;
+        size_t shardPuzzles = stats.puzzles;
+        if (!readWholeFile(shardPath(options.workDir, shard, ".stats"), line) || !addShardStats(line, stats) ||
+            !readWholeFile(shardPath(options.workDir, shard, ".out"), data) ||
+            stats.puzzles - shardPuzzles != min(count, (shard + 1) * options.shardSize) - shard * options.shardSize) {
+            cerr << "Damaged checkpoint: " << shardPath(options.workDir, shard, ".*")
+                 << "; delete it and run again\n";
+            return false;
+        }
+        if (corpus.isBinary()) {
+            writer.writePacked(data.data(), data.size());
+        } else {
+            output << data;
+        }
+    }
+    if (corpus.isBinary() ? !writer.close() : !output.flush()) {
+        cerr << "Cannot write output file: " << batch.outputPath << "\n";
+        return false;
+    }
+    return true;
+}
+
+#endif
+
+// Run a batch in checkpointed shards on the configured grid size
+inline bool runSharded(const ShardedOptions& options, BatchStats& stats) {
+#ifdef SUDOKU_SHARDED_RUN
+    switch (options.batch.boxSize) {
+        case 3: return runShardedOfSize<3>(options, stats);
+        case 4: return runShardedOfSize<4>(options, stats);
+        case 5: return runShardedOfSize<5>(options, stats);
+        default:
+            cerr << "Unsupported box size: " << options.batch.boxSize << "\n";
+            return false;
+    }
+#else
+    (void)options;
+    (void)stats;
+    cerr << "Sharded runs need POSIX processes and are not available on this platform\n";
+    return false;
+#endif
+}
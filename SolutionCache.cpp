@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include "Symmetry.cpp"
+
+using namespace std;
+
+// Fewest clues a board needs to go through the cache. Boards with fewer have
+// no unique solution, solve in microseconds and tie across the most
+// symmetries, so canonicalizing them costs more than it could save.
+const int MIN_CACHED_CLUES = 17;
+
+// Bounded LRU cache of solved 9x9 puzzles, keyed on the canonical form so
+// every relabeled, permuted or transposed copy of a puzzle shares one entry.
+// Solutions are stored in the canonical orientation; callers map them back
+// with the transform canonicalizeBoard() gave them. Unsolvable puzzles are
+// cached too. One cache can be shared by any number of solver threads.
+class SolutionCache {
+private:
+    struct Entry {
+        string key;                          // canonical puzzle, one byte per cell
+        bool solved;
+        uint8_t solution[81];                // canonical solution, if solved
+    };
+
+    size_t capacity_;
+    list<Entry> entries_;                    // most recently used first
+    unordered_map<string, list<Entry>::iterator> index_;
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t evictions_;
+    mutable mutex lock_;
+
+    SolutionCache(const SolutionCache&) = delete;
+    SolutionCache& operator=(const SolutionCache&) = delete;
+
+public:
+    explicit SolutionCache(size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1), hits_(0), misses_(0), evictions_(0) {}
+
+    // Look up a canonical puzzle; on a hit `solved` tells whether it has a
+    // solution, copied to `solution` in the canonical orientation
+    bool lookup(const uint8_t* canonical, uint8_t* solution, bool& solved) {
+        string key((const char*)canonical, 81);
+        lock_guard<mutex> guard(lock_);
+        unordered_map<string, list<Entry>::iterator>::iterator found = index_.find(key);
+        if (found == index_.end()) {
+            misses_++;
+            return false;
+        }
+        hits_++;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        solved = found->second->solved;
+        if (solved) memcpy(solution, found->second->solution, 81);
+        return true;
+    }
+
+    // Record the outcome for a canonical puzzle, evicting the least recently
+    // used entry when full
+    void store(const uint8_t* canonical, const uint8_t* solution, bool solved) {
+        string key((const char*)canonical, 81);
+        lock_guard<mutex> guard(lock_);
+        unordered_map<string, list<Entry>::iterator>::iterator found = index_.find(key);
+        if (found != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return;
+        }
+        if (entries_.size() >= capacity_) {
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+            evictions_++;
+        }
+
+        Entry entry;
+        entry.key = key;
+        entry.solved = solved;
+        if (solved) {
+            memcpy(entry.solution, solution, 81);
+        } else {
+            memset(entry.solution, 0, 81);
+        }
+        entries_.push_front(entry);
+        index_[key] = entries_.begin();
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    size_t size() const {
+        lock_guard<mutex> guard(lock_);
+        return entries_.size();
+    }
+
+    uint64_t hits() const {
+        lock_guard<mutex> guard(lock_);
+        return hits_;
+    }
+
+    uint64_t misses() const {
+        lock_guard<mutex> guard(lock_);
+        return misses_;
+    }
+
+    uint64_t evictions() const {
+        lock_guard<mutex> guard(lock_);
+        return evictions_;
+    }
+
+    void clear() {
+        lock_guard<mutex> guard(lock_);
+        entries_.clear();
+        index_.clear();
+        hits_ = misses_ = evictions_ = 0;
+    }
+};
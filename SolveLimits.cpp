@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+
+using namespace std;
+
+// Outcome of a solve run under limits
+enum SolveStatus {
+    SOLVE_SOLVED,
+    SOLVE_UNSOLVABLE,
+    SOLVE_TIMED_OUT,                         // deadline passed or node budget spent
+    SOLVE_CANCELLED
+};
+
+const char* const SOLVE_STATUS_NAMES[] = {"solved", "unsolvable", "timeout", "cancelled"};
+
+// Flag another thread raises to stop the solves watching it. A token linked
+// to a parent also reads as cancelled once the parent is.
+class CancellationToken {
+private:
+    atomic<bool> cancelled_;
+    const CancellationToken* parent_;
+
+public:
+    CancellationToken() : cancelled_(false), parent_(nullptr) {}
+
+    // Follow another token too (nullptr to stop); it must outlive this one
+    void link(const CancellationToken* parent) {
+        parent_ = parent;
+    }
+
+    void cancel() {
+        cancelled_.store(true, memory_order_relaxed);
+    }
+
+    void reset() {
+        cancelled_.store(false, memory_order_relaxed);
+    }
+
+    bool isCancelled() const {
+        return cancelled_.load(memory_order_relaxed) || (parent_ && parent_->isCancelled());
+    }
+};
+
+// Bounds on one solve: any mix of a deadline, a node budget and a
+// cancellation token (not owned; it must outlive the solve)
+struct SolveLimits {
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+    uint64_t maxNodes = 0;                   // 0 for no budget
+    const CancellationToken* token = nullptr;
+
+    // Deadline `milliseconds` from now
+    static SolveLimits timeout(double milliseconds) {
+        SolveLimits limits;
+        limits.deadline = chrono::steady_clock::now() +
+                          chrono::duration_cast<chrono::steady_clock::duration>(
+                              chrono::duration<double, milli>(milliseconds));
+        return limits;
+    }
+};
+
+// Limits of the running solve, checked at every search node. A relaxed
+// load for the token and a compare for the budget are all a node pays;
+// the clock is read once every CLOCK_INTERVAL nodes.
+class SolveBudget {
+private:
+    static const uint64_t CLOCK_INTERVAL = 256;
+
+    SolveLimits limits_;
+    bool active_;
+    bool timed_;                             // a deadline is set
+    SolveStatus stop_;                       // why the search stopped, once it has
+    bool stopped_;
+
+public:
+    SolveBudget() : active_(false), timed_(false), stop_(SOLVE_UNSOLVABLE), stopped_(false) {}
+
+    void start(const SolveLimits& limits) {
+        limits_ = limits;
+        timed_ = limits.deadline != chrono::steady_clock::time_point::max();
+        active_ = timed_ || limits.maxNodes > 0 || limits.token != nullptr;
+        stopped_ = false;
+    }
+
+    void clear() {
+        active_ = false;
+        stopped_ = false;
+    }
+
+    // True once the search has to stop; `nodes` is the solve's node count
+    bool exhausted(uint64_t nodes) {
+        if (!active_) return false;
+        if (stopped_) return true;
+        if (limits_.token && limits_.token->isCancelled()) {
+            stop_ = SOLVE_CANCELLED;
+            stopped_ = true;
+        } else if ((limits_.maxNodes > 0 && nodes > limits_.maxNodes) ||
+                   (timed_ && nodes % CLOCK_INTERVAL == 0 && chrono::steady_clock::now() >= limits_.deadline)) {
+            stop_ = SOLVE_TIMED_OUT;
+            stopped_ = true;
+        }
+        return stopped_;
+    }
+
+    bool stopped() const {
+        return stopped_;
+    }
+
+    // Stop the running solve from outside, as if a limit had been hit
+    void stop(SolveStatus reason) {
+        stop_ = reason;
+        stopped_ = true;
+    }
+
+    // Limits of the running solve; none when it has no limits
+    SolveLimits limits() const {
+        return active_ ? limits_ : SolveLimits();
+    }
+
+    // SOLVE_TIMED_OUT or SOLVE_CANCELLED once stopped
+    SolveStatus reason() const {
+        return stop_;
+    }
+};
@@ -0,0 +1,790 @@
+#pragma once
+#include "SudokuSolver.cpp"
+#include "BatchSolver.cpp"
+#include "BoardState.cpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define SUDOKU_HTTP_SERVER 1
+#endif
+
+using namespace std;
+
+// Solve service configuration
+struct ServerOptions {
+    string host = "127.0.0.1";
+    int port = 8000;
+    int threads = 0;                         // workers, 0 for one per hardware thread
+    size_t queueDepth = 64;                  // requests waiting for a worker before 503s
+    string rootDir = ".";                    // where index.html, styles.css, script.js live
+    int idleSeconds = 5;                     // keep-alive connections idle longer are closed, and the
+                                             // headers of a request must arrive within this
+    int requestSeconds = 30;                 // a whole request, headers and body, must arrive within this
+    size_t maxBodyBytes = 8 << 20;
+    size_t cacheSize = 10000;                // solved puzzles kept across requests, 0 for none
+    double solveTimeoutMs = 2000;            // per-puzzle solve deadline, 0 for none
+    double batchTimeoutMs = 10000;           // whole /api/batch request, 0 for none
+    size_t maxBoards = 1000;                 // live play boards, least recently used dropped beyond
+};
+
+// One parsed HTTP request
+struct HttpRequest {
+    string method;
+    string path;
+    string query;
+    string version;
+    string body;
+    bool keepAlive = true;
+};
+
+struct HttpResponse {
+    int status = 200;
+    string contentType = "application/json";
+    string body;
+    vector<string> headers;                  // extra "Name: value" lines
+};
+
+// Value of one query parameter ("engine" in "engine=dlx&unique=1")
+inline string queryParam(const string& query, const string& name) {
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t end = query.find('&', start);
+        if (end == string::npos) end = query.size();
+        string pair = query.substr(start, end - start);
+        size_t equals = pair.find('=');
+        if (pair.substr(0, equals) == name) {
+            return equals == string::npos ? "1" : pair.substr(equals + 1);
+        }
+        start = end + 1;
+    }
+    return "";
+}
+
+inline const char* statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "Error";
+    }
+}
+
+// JSON of a BoardSolvability
+const char* const BOARD_SOLVABILITY_JSON[] = {"\"unknown\"", "true", "false"};
+
+inline string jsonError(const string& message) {
+    return "{\"error\": \"" + message + "\"}";
+}
+
+#ifdef SUDOKU_HTTP_SERVER
+
+// Multithreaded HTTP solve service. One thread polls the listening socket
+// and the idle keep-alive connections; a connection with a request waiting
+// goes into a bounded queue served by a fixed pool of workers, each with its
+// own solver. When the queue is full the request is answered with 503 right
+// away, so a flood of clients slows down instead of piling up.
+class SolveServer {
+private:
+    // Board a player is editing, kept between requests
+    struct PlayBoard {
+        mutex lock;
+        BoardState state;
+        chrono::steady_clock::time_point lastUsed;   // guarded by boardsLock_
+    };
+
+    struct Connection {
+        int fd;
+        string buffer;                       // bytes read but not yet parsed
+        chrono::steady_clock::time_point lastActive;
+    };
+
+    enum ReadResult {
+        READ_OK,
+        READ_CLOSED,
+        READ_BAD,
+        READ_TOO_LARGE,
+        READ_TIMED_OUT
+    };
+
+    ServerOptions options_;
+    int listenFd_;
+    int wakePipe_[2];                        // workers wake the poller when they return a connection
+
+    mutex queueLock_;
+    condition_variable queueReady_;
+    deque<Connection*> queue_;
+
+    mutex idleLock_;
+    vector<Connection*> idle_;               // connections waiting for their next request
+
+    atomic<bool> stopping_;
+    atomic<uint64_t> requests_;
+    atomic<uint64_t> rejected_;
+    atomic<uint64_t> puzzles_;
+    int workerCount_;
+    unique_ptr<SolutionCache> cache_;        // shared by every worker's solver
+
+    mutex boardsLock_;
+    unordered_map<string, shared_ptr<PlayBoard>> boards_;
+    mt19937_64 boardIds_;
+
+    static atomic<bool>* stopFlag() {
+        static atomic<bool> flag(false);
+        return &flag;
+    }
+
+    static void handleSignal(int) {
+        stopFlag()->store(true);
+    }
+
+    static void closeConnection(Connection* conn) {
+        close(conn->fd);
+        delete conn;
+    }
+
+    static bool sendAll(int fd, const string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+
+    static string formatResponse(const HttpResponse& response, bool keepAlive) {
+        ostringstream out;
+        out << "HTTP/1.1 " << response.status << " " << statusText(response.status) << "\r\n";
+        out << "Content-Type: " << response.contentType << "\r\n";
+        out << "Content-Length: " << response.body.size() << "\r\n";
+        out << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n";
+        out << "Access-Control-Allow-Origin: *\r\n";
+        for (size_t i = 0; i < response.headers.size(); i++) {
+            out << response.headers[i] << "\r\n";
+        }
+        out << "\r\n" << response.body;
+        return out.str();
+    }
+
+    // Append what the connection has to its buffer, waiting for it until
+    // the deadline at most
+    ReadResult receive(Connection& conn, chrono::steady_clock::time_point deadline) {
+        char chunk[16 << 10];
+        auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+        if (left.count() <= 0) return READ_TIMED_OUT;
+        pollfd ready = {conn.fd, POLLIN, 0};
+        int polled = poll(&ready, 1, (int)left.count());
+        if (polled == 0) return READ_TIMED_OUT;
+        if (polled < 0) return errno == EINTR ? READ_OK : READ_CLOSED;
+        ssize_t n = recv(conn.fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return READ_CLOSED;
+        conn.buffer.append(chunk, n);
+        return READ_OK;
+    }
+
+    // Read one request from a connection. The headers must be in within the
+    // idle timeout and the whole request within requestSeconds, so a client
+    // trickling bytes cannot hold a worker past either.
+    ReadResult readRequest(Connection& conn, HttpRequest& request) {
+        const size_t maxHeaderBytes = 16 << 10;
+        auto start = chrono::steady_clock::now();
+        auto headerDeadline = start + chrono::seconds(options_.idleSeconds);
+        auto requestDeadline = start + chrono::seconds(options_.requestSeconds);
+
+        size_t headerEnd;
+        while ((headerEnd = conn.buffer.find("\r\n\r\n")) == string::npos) {
+            if (conn.buffer.size() > maxHeaderBytes) return READ_TOO_LARGE;
+            ReadResult result = receive(conn, min(headerDeadline, requestDeadline));
+            if (result != READ_OK) return result;
+        }
+
+        istringstream head(conn.buffer.substr(0, headerEnd));
+        string line, target;
+        if (!getline(head, line)) return READ_BAD;
+        istringstream requestLine(line);
+        if (!(requestLine >> request.method >> target >> request.version)) return READ_BAD;
+        size_t question = target.find('?');
+        request.path = target.substr(0, question);
+        request.query = question == string::npos ? "" : target.substr(question + 1);
+        request.keepAlive = request.version == "HTTP/1.1";
+
+        size_t contentLength = 0;
+        while (getline(head, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t colon = line.find(':');
+            if (colon == string::npos) continue;
+            string name = line.substr(0, colon), value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(" \t"));
+            for (size_t i = 0; i < name.size(); i++) name[i] = tolower(name[i]);
+            for (size_t i = 0; i < value.size(); i++) value[i] = tolower(value[i]);
+            if (name == "content-length") {
+                contentLength = strtoull(value.c_str(), nullptr, 10);
+            } else if (name == "connection") {
+                if (value == "close") request.keepAlive = false;
+                if (value == "keep-alive") request.keepAlive = true;
+            } else if (name == "transfer-encoding" && value != "identity") {
+                return READ_BAD;
+            }
+        }
+        if (contentLength > options_.maxBodyBytes) return READ_TOO_LARGE;
+
+        size_t bodyStart = headerEnd + 4;
+        while (conn.buffer.size() < bodyStart + contentLength) {
+            ReadResult result = receive(conn, requestDeadline);
+            if (result != READ_OK) return result;
+        }
+        request.body = conn.buffer.substr(bodyStart, contentLength);
+        conn.buffer.erase(0, bodyStart + contentLength);
+        return READ_OK;
+    }
+
+    // Engine and uniqueness settings from the query string. A request that
+    // names its engine wants that engine's own answer and timing, so only
+    // the default engine goes through the shared cache (cache=0 opts out)
+    bool solveOptions(const HttpRequest& request, SudokuSolver& solver, BatchOptions& batch,
+                      HttpResponse& response) {
+        string engine = queryParam(request.query, "engine");
+        bool useCache = engine.empty() && queryParam(request.query, "cache") != "0";
+        solver.setSolutionCache(useCache ? cache_.get() : nullptr);
+        if (engine.empty()) engine = "dlx";
+        if (!isSolverEngine(engine)) {
+            response.status = 400;
+            response.body = jsonError("unknown engine: " + engine);
+            return false;
+        }
+        batch.engineId = engine;
+        batch.requireUnique = queryParam(request.query, "unique") == "1";
+        batch.timeoutMs = options_.solveTimeoutMs;
+        return true;
+    }
+
+    // POST /api/solve: one puzzle line in the body, JSON result
+    void handleSolve(const HttpRequest& request, SudokuSolver& solver, HttpResponse& response) {
+        BatchOptions batch;
+        if (!solveOptions(request, solver, batch, response)) return;
+
+        PuzzleCorpus corpus;
+        corpus.openText(request.body.data(), request.body.size());
+
+        vector<Grid> results(1);
+        vector<uint8_t> statuses(1, PUZZLE_INVALID);
+        vector<SearchStats> searchStats(1);
+        vector<int8_t> winners(1, -1), routes(1, -1);
+
+        auto begin = chrono::steady_clock::now();
+        if (corpus.size() > 0) {
+            solveRange<3>(solver, nullptr, batch, corpus, 0, 1, results, statuses, searchStats, winners, routes);
+        }
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - begin;
+        puzzles_++;
+
+        ostringstream body;
+        body << "{\"status\": \"" << PUZZLE_STATUS_NAMES[statuses[0]] << "\"";
+        if (statuses[0] == PUZZLE_SOLVED) {
+            body << ", \"solution\": \"" << formatPuzzleLine(results[0]) << "\"";
+        }
+        body << ", \"engine\": \"" << batch.engineId << "\"";
+        if (solver.wasCacheHit()) body << ", \"cached\": true";
+        if (routes[0] >= 0) body << ", \"route\": \"" << SOLVE_ROUTE_NAMES[routes[0]] << "\"";
+        body << ", \"time_ms\": " << fixed << setprecision(3)
+             << elapsed.count() << ", \"nodes\": " << searchStats[0].nodes << "}";
+        response.body = body.str();
+    }
+
+    // POST /api/batch: puzzle lines in the body, one result line per puzzle
+    // in the batch-mode format
+    void handleBatch(const HttpRequest& request, SudokuSolver& solver, HttpResponse& response) {
+        BatchOptions batch;
+        if (!solveOptions(request, solver, batch, response)) return;
+
+        // A body of many puzzles must not hold the worker for the per-puzzle
+        // deadline times their number; the ones left at the end time out
+        if (options_.batchTimeoutMs > 0) batch.deadline = SolveLimits::timeout(options_.batchTimeoutMs).deadline;
+
+        PuzzleCorpus corpus;
+        corpus.openText(request.body.data(), request.body.size());
+        size_t count = corpus.size();
+
+        vector<Grid> results(count);
+        vector<uint8_t> statuses(count, PUZZLE_INVALID);
+        vector<SearchStats> searchStats;
+        vector<int8_t> winners(count, -1), routes(count, -1);
+
+        auto begin = chrono::steady_clock::now();
+        solveRange<3>(solver, nullptr, batch, corpus, 0, count, results, statuses, searchStats, winners, routes);
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - begin;
+        puzzles_ += count;
+
+        string body;
+        body.reserve(count * 82);
+        for (size_t i = 0; i < count; i++) {
+            body += formatResultLine<3>(statuses[i], results[i]);
+            body += '\n';
+        }
+        ostringstream timing;
+        timing << "X-Solve-Time-Ms: " << fixed << setprecision(3) << elapsed.count();
+        response.contentType = "text/plain";
+        response.body = body;
+        response.headers.push_back("X-Puzzles: " + to_string(count));
+        response.headers.push_back(timing.str());
+    }
+
+    // GET /api/stats: service counters for load tests
+    void handleStats(HttpResponse& response) {
+        size_t waiting;
+        {
+            lock_guard<mutex> guard(queueLock_);
+            waiting = queue_.size();
+        }
+        ostringstream body;
+        body << "{\"workers\": " << workerCount_ << ", \"queue_depth\": " << options_.queueDepth
+             << ", \"queued\": " << waiting << ", \"requests\": " << requests_.load()
+             << ", \"rejected\": " << rejected_.load() << ", \"puzzles\": " << puzzles_.load();
+        if (cache_) {
+            body << ", \"cache_size\": " << cache_->size() << ", \"cache_hits\": " << cache_->hits()
+                 << ", \"cache_misses\": " << cache_->misses();
+        }
+        {
+            lock_guard<mutex> guard(boardsLock_);
+            body << ", \"boards\": " << boards_.size();
+        }
+        body << "}";
+        response.body = body.str();
+    }
+
+    // Play board named by the id parameter, or a 404
+    shared_ptr<PlayBoard> findBoard(const HttpRequest& request, HttpResponse& response) {
+        string id = queryParam(request.query, "id");
+        lock_guard<mutex> guard(boardsLock_);
+        auto found = boards_.find(id);
+        if (found == boards_.end()) {
+            response.status = 404;
+            response.body = jsonError("unknown board: " + id);
+            return nullptr;
+        }
+        found->second->lastUsed = chrono::steady_clock::now();
+        return found->second;
+    }
+
+    // Fields every board reply carries; call with the board locked. The
+    // board's searches stop at the solve deadline, and "solvable" is then
+    // "unknown" instead of true or false.
+    static void writeBoardState(BoardState& state, ostringstream& body) {
+        body << "\"empty\": " << state.emptyCount() << ", \"conflicts\": " << state.conflictCount()
+             << ", \"solvable\": " << BOARD_SOLVABILITY_JSON[state.solvability()]
+             << ", \"grid\": \"" << formatPuzzleLine(state.grid()) << "\"";
+    }
+
+    // POST /api/board: start a play board from the puzzle line in the body
+    void handleNewBoard(const HttpRequest& request, HttpResponse& response) {
+        string line = request.body.substr(0, request.body.find_last_not_of(" \t\r\n") + 1);
+        Grid puzzle;
+        if (!parsePuzzleLine(line.data(), line.size(), puzzle)) {
+            response.status = 400;
+            response.body = jsonError("bad puzzle");
+            return;
+        }
+
+        shared_ptr<PlayBoard> board(new PlayBoard());
+        board->state.setTimeout(options_.solveTimeoutMs);
+        board->state.load(puzzle);
+        string id;
+        {
+            lock_guard<mutex> guard(boardsLock_);
+            if (boards_.size() >= options_.maxBoards) {
+                auto oldest = boards_.begin();
+                for (auto it = boards_.begin(); it != boards_.end(); ++it) {
+                    if (it->second->lastUsed < oldest->second->lastUsed) oldest = it;
+                }
+                boards_.erase(oldest);
+            }
+            ostringstream name;
+            name << hex << setw(16) << setfill('0') << boardIds_();
+            id = name.str();
+            board->lastUsed = chrono::steady_clock::now();
+            boards_[id] = board;
+        }
+
+        lock_guard<mutex> guard(board->lock);
+        ostringstream body;
+        body << "{\"board\": \"" << id << "\", ";
+        writeBoardState(board->state, body);
+        body << "}";
+        response.body = body.str();
+    }
+
+    // POST /api/board/move?id=&cell=&digit=: set a cell (digit 0 clears it)
+    // and report whether the move was legal and the board is still solvable
+    void handleMove(const HttpRequest& request, HttpResponse& response) {
+        shared_ptr<PlayBoard> board = findBoard(request, response);
+        if (!board) return;
+        string cellParam = queryParam(request.query, "cell"), digitParam = queryParam(request.query, "digit");
+        int cell = atoi(cellParam.c_str()), digit = atoi(digitParam.c_str());
+        if (cellParam.empty() || digitParam.empty() || cell < 0 || cell >= 81 || digit < 0 || digit > 9) {
+            response.status = 400;
+            response.body = jsonError("bad move");
+            return;
+        }
+
+        lock_guard<mutex> guard(board->lock);
+        if (board->state.isGiven(cell)) {
+            response.status = 400;
+            response.body = jsonError("cell is a given");
+            return;
+        }
+        bool legal = digit == 0 || board->state.isLegal(cell, digit);
+        board->state.set(cell, digit);
+        ostringstream body;
+        body << "{\"legal\": " << (legal ? "true" : "false") << ", ";
+        writeBoardState(board->state, body);
+        body << "}";
+        response.body = body.str();
+    }
+
+    // GET /api/board/hint?id=: next step for the player
+    void handleHint(const HttpRequest& request, HttpResponse& response) {
+        shared_ptr<PlayBoard> board = findBoard(request, response);
+        if (!board) return;
+
+        lock_guard<mutex> guard(board->lock);
+        BoardHint hint = board->state.nextHint();
+        ostringstream body;
+        body << "{\"hint\": \"" << HINT_KIND_NAMES[hint.kind] << "\", \"cell\": " << hint.cell
+             << ", \"digit\": " << hint.digit << ", ";
+        writeBoardState(board->state, body);
+        body << "}";
+        response.body = body.str();
+    }
+
+    // Static front-end files from the root directory
+    void handleFile(const HttpRequest& request, HttpResponse& response) {
+        string path = request.path == "/" ? "/index.html" : request.path;
+        const char* types[][2] = {
+            {".html", "text/html; charset=utf-8"},
+            {".css", "text/css; charset=utf-8"},
+            {".js", "application/javascript; charset=utf-8"}
+        };
+        const char* type = nullptr;
+        for (size_t i = 0; i < 3; i++) {
+            size_t length = strlen(types[i][0]);
+            if (path.size() > length && path.compare(path.size() - length, length, types[i][0]) == 0) {
+                type = types[i][1];
+            }
+        }
+
+        ifstream file;
+        if (type && path.find("..") == string::npos) {
+            file.open((options_.rootDir + path).c_str(), ios::binary);
+        }
+        if (!file.is_open()) {
+            response.status = 404;
+            response.body = jsonError("not found");
+            return;
+        }
+        ostringstream content;
+        content << file.rdbuf();
+        response.contentType = type;
+        response.body = content.str();
+    }
+
+    void route(const HttpRequest& request, SudokuSolver& solver, HttpResponse& response) {
+        if (request.method == "OPTIONS") {
+            response.status = 204;
+            response.headers.push_back("Access-Control-Allow-Methods: GET, POST, OPTIONS");
+            response.headers.push_back("Access-Control-Allow-Headers: Content-Type");
+            return;
+        }
+
+        bool isPost = request.method == "POST";
+        if (request.path == "/api/solve" || request.path == "/api/batch" ||
+            request.path == "/api/board" || request.path == "/api/board/move") {
+            if (!isPost) {
+                response.status = 405;
+                response.body = jsonError("use POST");
+            } else if (request.path == "/api/solve") {
+                handleSolve(request, solver, response);
+            } else if (request.path == "/api/batch") {
+                handleBatch(request, solver, response);
+            } else if (request.path == "/api/board") {
+                handleNewBoard(request, response);
+            } else {
+                handleMove(request, response);
+            }
+        } else if (request.method != "GET") {
+            response.status = 405;
+            response.body = jsonError("method not allowed");
+        } else if (request.path == "/api/stats") {
+            handleStats(response);
+        } else if (request.path == "/api/board/hint") {
+            handleHint(request, response);
+        } else {
+            handleFile(request, response);
+        }
+    }
+
+    // Serve requests on a connection while they keep coming. Returns true
+    // to hand the connection back to the poller, false once it is closed.
+    bool serveConnection(Connection& conn, SudokuSolver& solver) {
+        for (;;) {
+            HttpRequest request;
+            ReadResult result = readRequest(conn, request);
+            if (result == READ_CLOSED) return false;
+
+            HttpResponse response;
+            if (result == READ_OK) {
+                requests_++;
+                route(request, solver, response);
+            } else {
+                response.status = result == READ_TOO_LARGE ? 413 : result == READ_TIMED_OUT ? 408 : 400;
+                response.body = jsonError(statusText(response.status));
+                request.keepAlive = false;
+            }
+
+            bool keepAlive = request.keepAlive && !stopping_.load();
+            if (!sendAll(conn.fd, formatResponse(response, keepAlive)) || !keepAlive) return false;
+
+            // A pipelined request already in the buffer is served right away
+            if (conn.buffer.find("\r\n\r\n") == string::npos) return true;
+        }
+    }
+
+    void workerLoop() {
+        SudokuSolver solver;
+        for (;;) {
+            Connection* conn;
+            {
+                unique_lock<mutex> guard(queueLock_);
+                queueReady_.wait(guard, [this]() { return !queue_.empty() || stopping_.load(); });
+                if (queue_.empty()) return;
+                conn = queue_.front();
+                queue_.pop_front();
+            }
+
+            if (!serveConnection(*conn, solver)) {
+                closeConnection(conn);
+                continue;
+            }
+
+            conn->lastActive = chrono::steady_clock::now();
+            {
+                lock_guard<mutex> guard(idleLock_);
+                idle_.push_back(conn);
+            }
+            char wake = 1;
+            if (write(wakePipe_[1], &wake, 1) < 0) {
+                // The poller picks the connection up on its next timeout anyway
+            }
+        }
+    }
+
+    // Queue a connection with a request waiting, or turn it away with 503
+    void dispatch(Connection* conn) {
+        {
+            lock_guard<mutex> guard(queueLock_);
+            if (queue_.size() < options_.queueDepth) {
+                queue_.push_back(conn);
+                queueReady_.notify_one();
+                return;
+            }
+        }
+        rejected_++;
+
+        // Read what the client already sent, so closing does not reset the
+        // connection and lose the 503 on the way
+        char drain[16 << 10];
+        while (recv(conn->fd, drain, sizeof(drain), MSG_DONTWAIT) > 0) {
+        }
+
+        HttpResponse response;
+        response.status = 503;
+        response.body = jsonError("server busy");
+        response.headers.push_back("Retry-After: 1");
+        sendAll(conn->fd, formatResponse(response, false));
+        closeConnection(conn);
+    }
+
+    void acceptConnections() {
+        for (;;) {
+            int fd = accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) return;
+
+            // Blocking reads with a timeout, as a backstop to the per-request
+            // deadlines of readRequest
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+            timeval timeout = {options_.idleSeconds, 0};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            Connection* conn = new Connection();
+            conn->fd = fd;
+            conn->lastActive = chrono::steady_clock::now();
+            lock_guard<mutex> guard(idleLock_);
+            idle_.push_back(conn);
+        }
+    }
+
+    void pollLoop() {
+        vector<pollfd> fds;
+        vector<Connection*> watched;
+        while (!stopFlag()->load()) {
+            {
+                lock_guard<mutex> guard(idleLock_);
+                watched.swap(idle_);
+                idle_.clear();
+            }
+
+            fds.assign(2 + watched.size(), pollfd());
+            fds[0].fd = wakePipe_[0];
+            fds[1].fd = listenFd_;
+            for (size_t i = 0; i < watched.size(); i++) fds[2 + i].fd = watched[i]->fd;
+            for (size_t i = 0; i < fds.size(); i++) fds[i].events = POLLIN;
+
+            poll(fds.data(), fds.size(), 1000);
+
+            if (fds[0].revents & POLLIN) {
+                char drain[64];
+                while (read(wakePipe_[0], drain, sizeof(drain)) == (ssize_t)sizeof(drain)) {
+                }
+            }
+
+            // Ready connections go to the workers, quiet ones wait again and
+            // the ones idle for too long are closed
+            auto now = chrono::steady_clock::now();
+            vector<Connection*> waiting;
+            for (size_t i = 0; i < watched.size(); i++) {
+                short events = fds[2 + i].revents;
+                if (events & POLLIN) {
+                    dispatch(watched[i]);
+                } else if ((events & (POLLERR | POLLHUP | POLLNVAL)) ||
+                           now - watched[i]->lastActive > chrono::seconds(options_.idleSeconds)) {
+                    closeConnection(watched[i]);
+                } else {
+                    waiting.push_back(watched[i]);
+                }
+            }
+            watched.clear();
+
+            {
+                lock_guard<mutex> guard(idleLock_);
+                idle_.insert(idle_.end(), waiting.begin(), waiting.end());
+            }
+            if (fds[1].revents & POLLIN) {
+                acceptConnections();
+            }
+        }
+    }
+
+public:
+    explicit SolveServer(const ServerOptions& options)
+        : options_(options), listenFd_(-1), stopping_(false), requests_(0), rejected_(0), puzzles_(0),
+          workerCount_(0), boardIds_(random_device()()) {
+        wakePipe_[0] = wakePipe_[1] = -1;
+        if (options_.cacheSize > 0) cache_.reset(new SolutionCache(options_.cacheSize));
+    }
+
+    ~SolveServer() {
+        if (listenFd_ >= 0) close(listenFd_);
+        if (wakePipe_[0] >= 0) close(wakePipe_[0]);
+        if (wakePipe_[1] >= 0) close(wakePipe_[1]);
+        for (size_t i = 0; i < idle_.size(); i++) closeConnection(idle_[i]);
+    }
+
+    // Serve until interrupted (Ctrl+C); false if the socket cannot be opened
+    bool run() {
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, handleSignal);
+        signal(SIGTERM, handleSignal);
+
+        listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options_.port);
+        if (listenFd_ < 0 || inet_pton(AF_INET, options_.host.c_str(), &address.sin_addr) != 1 ||
+            ::bind(listenFd_, (sockaddr*)&address, sizeof(address)) < 0 || listen(listenFd_, 512) < 0) {
+            cerr << "Cannot listen on " << options_.host << ":" << options_.port << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        fcntl(listenFd_, F_SETFL, fcntl(listenFd_, F_GETFL) | O_NONBLOCK);
+        if (pipe(wakePipe_) < 0) return false;
+        fcntl(wakePipe_[0], F_SETFL, fcntl(wakePipe_[0], F_GETFL) | O_NONBLOCK);
+
+        workerCount_ = options_.threads > 0 ? options_.threads : (int)thread::hardware_concurrency();
+        if (workerCount_ < 1) workerCount_ = 1;
+
+        cout << "🎯 Sudoku Solver Master - Solve Service\n";
+        cout << string(50, '=') << "\n";
+        cout << "🌐 Serving at: http://" << options_.host << ":" << options_.port << "\n";
+        cout << "📁 Front end from: " << options_.rootDir << "\n";
+        cout << "⚙️  " << workerCount_ << " workers, queue depth " << options_.queueDepth << "\n";
+        cout << string(50, '=') << "\n";
+        cout << "Press Ctrl+C to stop the server\n" << flush;
+
+        vector<thread> workers;
+        for (int w = 0; w < workerCount_; w++) {
+            workers.push_back(thread([this]() { workerLoop(); }));
+        }
+
+        pollLoop();
+
+        // Let the workers finish the queued requests, then stop
+        stopping_.store(true);
+        queueReady_.notify_all();
+        for (size_t w = 0; w < workers.size(); w++) {
+            workers[w].join();
+        }
+
+        cout << "\n🛑 Server stopped: " << requests_.load() << " requests, " << rejected_.load()
+             << " rejected, " << puzzles_.load() << " puzzles\n";
+        return true;
+    }
+};
+
+#endif
+
+// Run the solve service; false if it could not start
+inline bool runServer(const ServerOptions& options) {
+#ifdef SUDOKU_HTTP_SERVER
+    SolveServer server(options);
+    return server.run();
+#else
+    (void)options;
+    cerr << "The solve service needs POSIX sockets and is not available on this platform\n";
+    return false;
+#endif
+}
@@ -0,0 +1,114 @@
+#include "sudoku.h"
+#include "SudokuSolver.cpp"
+#include <new>
+#include <cstdint>
+
+using namespace std;
+
+// C interface (sudoku.h) over the 9x9 solver. The solver is constructed in
+// the caller's scratch block and only the engines that keep their state on
+// the stack are offered, so no call allocates.
+
+static_assert(SUDOKU_RULE_HIDDEN_SINGLES == 1u << RULE_HIDDEN_SINGLES &&
+              SUDOKU_RULE_NAKED_PAIRS == 1u << RULE_NAKED_PAIRS &&
+              SUDOKU_RULE_HIDDEN_PAIRS == 1u << RULE_HIDDEN_PAIRS &&
+              SUDOKU_RULE_POINTING == 1u << RULE_POINTING &&
+              SUDOKU_RULE_BOX_LINE == 1u << RULE_BOX_LINE &&
+              SUDOKU_ALL_RULES == ALL_INFERENCE_RULES, "sudoku.h rule bits out of date");
+
+// Solver and a marker telling an initialized block from stray memory
+struct sudoku_scratch {
+    static const uint32_t MAGIC = 0x5344534fu;
+
+    uint32_t magic;
+    SudokuSolver solver;
+
+    sudoku_scratch() : magic(MAGIC) {}
+    ~sudoku_scratch() {
+        magic = 0;
+    }
+};
+
+extern "C" size_t sudoku_scratch_size(void) {
+    return sizeof(sudoku_scratch) + alignof(sudoku_scratch) - 1;
+}
+
+extern "C" sudoku_scratch* sudoku_scratch_init(void* memory, size_t size) {
+    if (!memory || size < sudoku_scratch_size()) return nullptr;
+    uintptr_t address = (uintptr_t)memory;
+    address = (address + alignof(sudoku_scratch) - 1) & ~(uintptr_t)(alignof(sudoku_scratch) - 1);
+    return new ((void*)address) sudoku_scratch();
+}
+
+extern "C" void sudoku_scratch_release(sudoku_scratch* scratch) {
+    if (scratch && scratch->magic == sudoku_scratch::MAGIC) scratch->~sudoku_scratch();
+}
+
+extern "C" void sudoku_default_options(sudoku_options* options) {
+    if (!options) return;
+    options->engine = SUDOKU_ENGINE_BITMASK;
+    options->rules = SUDOKU_ALL_RULES;
+    options->check_unique = 0;
+    options->timeout_ms = 0;
+    options->max_nodes = 0;
+}
+
+extern "C" int sudoku_solve(const char* in, char* out, const sudoku_options* options, sudoku_scratch* scratch) {
+    if (!in || !out || !scratch || scratch->magic != sudoku_scratch::MAGIC) return SUDOKU_ERROR;
+    sudoku_options defaults;
+    if (!options) {
+        sudoku_default_options(&defaults);
+        options = &defaults;
+    }
+    if (options->engine != SUDOKU_ENGINE_BITMASK && options->engine != SUDOKU_ENGINE_BACKTRACKING) {
+        return SUDOKU_ERROR;
+    }
+
+    try {
+        Grid grid;
+        for (int cell = 0; cell < 81; cell++) {
+            char symbol = in[cell];
+            if (symbol >= '1' && symbol <= '9') {
+                grid[cell] = symbol - '0';
+            } else if (symbol == '0' || symbol == '.') {
+                grid[cell] = 0;
+            } else {
+                return SUDOKU_INVALID;
+            }
+        }
+
+        SudokuSolver& solver = scratch->solver;
+        solver.setInferenceRules(options->rules);
+        solver.setBoard(grid);
+        if (solver.hasConflicts()) return SUDOKU_INVALID;
+
+        // The uniqueness check and the solve share one deadline
+        SolveLimits limits = options->timeout_ms > 0 ? SolveLimits::timeout(options->timeout_ms) : SolveLimits();
+        limits.maxNodes = options->max_nodes;
+        if (options->check_unique) {
+            size_t solutions;
+            if (solver.countSolutionsWithLimits(2, limits, solutions) != SOLVE_SOLVED) return SUDOKU_TIMED_OUT;
+            if (solutions == 0) return SUDOKU_UNSOLVABLE;
+            if (solutions > 1) return SUDOKU_MULTIPLE;
+        }
+
+        bool (SudokuSolver::*engine)() = options->engine == SUDOKU_ENGINE_BACKTRACKING
+                                       ? &SudokuSolver::solveBacktracking : &SudokuSolver::solveBitmask;
+        switch (solver.solveWithLimits(engine, limits)) {
+            case SOLVE_SOLVED: break;
+            case SOLVE_UNSOLVABLE: return SUDOKU_UNSOLVABLE;
+            default: return SUDOKU_TIMED_OUT;
+        }
+
+        const Grid& solution = solver.getGrid();
+        for (int cell = 0; cell < 81; cell++) out[cell] = '0' + solution[cell];
+        return SUDOKU_SOLVED;
+    } catch (...) {
+        return SUDOKU_ERROR;
+    }
+}
+
+extern "C" const char* sudoku_status_name(int status) {
+    static const char* const names[] = {"solved", "unsolvable", "invalid", "multiple", "timeout", "error"};
+    return status >= 0 && status <= SUDOKU_ERROR ? names[status] : "unknown";
+}
@@ -1,274 +1,1369 @@
+#pragma once
 #include <iostream>
 #include <vector>
-#include <set>
+#include <array>
+#include <string>
+#include <utility>
 #include <chrono>
 #include <iomanip>
 #include <cstring>
+#include <cstdint>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include "Geometry.cpp"
+#include "DancingLinks.cpp"
+#include "PropagationKernel.cpp"
+#include "InferenceRules.cpp"
+#include "SearchStats.cpp"
+#include "SolveLimits.cpp"
+#include "SearchHeuristics.cpp"
+#include "EngineRouter.cpp"
+#include "SolutionCache.cpp"
 
 using namespace std;
 
-class SudokuSolver {
+// Flat board layout: all cells in row-major order, 0 for an empty cell
+template <int BoxSize>
+using BasicGrid = array<uint8_t, GridShape<BoxSize>::CELLS>;
+
+typedef BasicGrid<3> Grid;
+
+// All nine digits as a candidate mask (bit d-1 stands for digit d)
+const uint16_t ALL_CANDIDATES = GridShape<3>::ALL;
+
+// Solver for grids of BoxSize x BoxSize boxes. Grid size, mask width and
+// all lookup tables are compile-time constants, so the 9x9 solver
+// (SudokuSolver) compiles to fully specialized code.
+template <int BoxSize>
+class BasicSudokuSolver {
+public:
+    typedef GridShape<BoxSize> Shape;
+    typedef typename Shape::Mask Mask;
+    typedef typename Shape::Cell Cell;
+    typedef BasicGrid<BoxSize> Grid;
+    typedef BasicCandidateGrid<BoxSize> CandidateGrid;
+
+    static constexpr int BOX = BoxSize;
+    static constexpr int N = Shape::N;
+    static constexpr int CELLS = Shape::CELLS;
+
 private:
-    vector<vector<int>> board;
-    int N = 9;
-    
+    static constexpr const GeometryTables<BoxSize>& geo = geometry<BoxSize>;
+
+    Grid board;
+
+    // Digits used in each row, column and box, kept in sync with the board
+    Mask rowUsed[N];
+    Mask colUsed[N];
+    Mask boxUsed[N];
+
+    // Naked-single propagation kernel picked for this CPU
+    const PropagationKernel<BoxSize>* kernel_;
+
+    // Inference rules run after the kernel (bits of InferenceRule) and how
+    // often each one fired
+    unsigned inferenceRules_;
+    mutable RuleCounters ruleCounters_;
+
+    // Counters of the last solve (see SearchStats.cpp)
+    SearchStats stats_;
+
+    // Exact-cover node pool, built on first use and reused across puzzles
+    unique_ptr<BasicDancingLinks<BoxSize>> dlx_;
+
+    // Fixed-size state of the iterative constraint search: candidate masks,
+    // one frame per open branch and the undo trail. A mask only shrinks
+    // along a path, so a path logs at most N changes per cell.
+    struct SearchTrail {
+        struct Frame {
+            Cell cell;
+            Mask remaining;                  // digits not tried yet
+            uint32_t mark;                   // trail size when the branch opened
+        };
+        struct Change {
+            Cell cell;
+            Mask mask;                       // candidates before the change
+        };
+
+        Mask candidates[CELLS];
+        Frame frames[CELLS];
+        Change changes[CELLS * N];
+        uint32_t size;
+
+        void save(int cell) {
+            changes[size].cell = cell;
+            changes[size].mask = candidates[cell];
+            size++;
+        }
+
+        void undo(uint32_t mark) {
+            while (size > mark) {
+                size--;
+                candidates[changes[size].cell] = changes[size].mask;
+            }
+        }
+    };
+
+    // Built on first use and reused across puzzles
+    unique_ptr<SearchTrail> trail_;
+
+    // Shared state of a constraint search split across threads. A
+    // subproblem is a board and candidate masks; each worker owns a deque of
+    // them, takes from the back of its own and steals from the front of the
+    // others', where the shallower, larger subtrees sit. A worker out of work
+    // sleeps on workReady until a subproblem is pushed or the search ends.
+    struct SplitSearch {
+        struct Subproblem {
+            Grid board;
+            Mask candidates[CELLS];
+        };
+        struct WorkerDeque {
+            mutex lock;
+            deque<Subproblem> items;
+        };
+
+        vector<unique_ptr<WorkerDeque>> deques;
+        atomic<int> idle;                    // workers out of work
+        atomic<int> queued;                  // subproblems waiting in the deques
+        atomic<int> pending;                 // subproblems queued or being searched
+        CancellationToken stop;              // ends every worker's search
+        mutex waitLock;
+        condition_variable workReady;
+        SolveLimits limits;                  // each worker's limits, watching `stop`
+        mutex resultLock;
+        bool solved;
+        Grid solution;
+        bool limited;                        // a worker hit the caller's limits
+        SolveStatus limitReason;
+
+        explicit SplitSearch(int workers)
+            : idle(0), queued(0), pending(0), solved(false), limited(false), limitReason(SOLVE_TIMED_OUT) {
+            for (int w = 0; w < workers; w++) {
+                deques.push_back(unique_ptr<WorkerDeque>(new WorkerDeque()));
+            }
+        }
+
+        void push(int worker, const Subproblem& subproblem) {
+            pending++;
+            WorkerDeque& own = *deques[worker];
+            lock_guard<mutex> guard(own.lock);
+            own.items.push_back(subproblem);
+            queued++;
+            wake(false);
+        }
+
+        // Wake one sleeping worker, or all of them when the search is over
+        void wake(bool all) {
+            {
+                // A worker between its predicate check and its wait holds the lock
+                lock_guard<mutex> guard(waitLock);
+            }
+            if (all) {
+                workReady.notify_all();
+            } else {
+                workReady.notify_one();
+            }
+        }
+
+        // Sleep until a subproblem is queued; false once nothing is left
+        // pending or the search was stopped
+        bool waitForWork() {
+            unique_lock<mutex> guard(waitLock);
+            workReady.wait(guard, [this]() {
+                return queued.load() > 0 || pending.load() == 0 || stop.isCancelled();
+            });
+            return queued.load() > 0 && !stop.isCancelled();
+        }
+
+        // Next subproblem for a worker; false if every deque is empty
+        bool take(int worker, Subproblem& subproblem) {
+            for (size_t offset = 0; offset < deques.size(); offset++) {
+                WorkerDeque& deque = *deques[(worker + offset) % deques.size()];
+                lock_guard<mutex> guard(deque.lock);
+                if (deque.items.empty()) continue;
+                if (offset == 0) {
+                    subproblem = deque.items.back();
+                    deque.items.pop_back();
+                } else {
+                    subproblem = deque.items.front();
+                    deque.items.pop_front();
+                }
+                queued--;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    // Threads the constraint engine splits its search across, and the split
+    // search this solver is a worker of (nullptr when searching alone)
+    int searchThreads_;
+    SplitSearch* split_;
+    int splitWorker_;
+
+    // Deadline, node budget and cancellation of the running solve
+    SolveBudget budget_;
+
+    // Shared solved-puzzle cache (9x9 only, not owned) and the canonical
+    // form of the board being solved, kept from lookup to store, and
+    // whether the last solve was answered by it
+    SolutionCache* cache_;
+    CanonicalBoard cacheKey_;
+    bool cacheHit_;
+
+    // Value order, restarts and nogoods of the backtracking and constraint
+    // engines (see SearchHeuristics.cpp), with their per-solve state: the
+    // Zobrist hash of the board (kept by place/unplace while nogoods are
+    // on), the random generator, whether this run orders at random, and the
+    // node count that ends it
+    SearchHeuristics heuristics_;
+    NogoodStore nogoods_;
+    uint64_t boardHash_;
+    uint64_t random_;
+    bool randomRun_;
+    uint64_t restartLimit_;                  // 0 for none
+    bool restarted_;                         // the run ended at restartLimit_
+
+    // Auto engine: its thresholds, the last puzzle's features and route,
+    // and the puzzles sent down each route so far
+    AutoRouting routing_;
+    PuzzleFeatures features_;
+    SolveRoute lastRoute_;
+    uint64_t routeCounts_[ROUTE_COUNT];
+
+    static Mask digitBit(int num) {
+        return (Mask)(1u << (num - 1));
+    }
+
+    // Write a digit into an empty cell and mark it used in its units
+    void place(int cell, int num) {
+        Mask digitMask = digitBit(num);
+        board[cell] = num;
+        if (heuristics_.nogoods > 0) boardHash_ ^= zobristKeys<BoxSize>.keys[cell][num];
+        rowUsed[geo.rowOf[cell]] |= digitMask;
+        colUsed[geo.colOf[cell]] |= digitMask;
+        boxUsed[geo.boxOf[cell]] |= digitMask;
+    }
+
+    // Clear a filled cell and release its digit in its units
+    void unplace(int cell) {
+        Mask digitMask = digitBit(board[cell]);
+        if (heuristics_.nogoods > 0) boardHash_ ^= zobristKeys<BoxSize>.keys[cell][board[cell]];
+        board[cell] = 0;
+        rowUsed[geo.rowOf[cell]] &= ~digitMask;
+        colUsed[geo.colOf[cell]] &= ~digitMask;
+        boxUsed[geo.boxOf[cell]] &= ~digitMask;
+    }
+
+    // Rebuild the unit masks after the whole board was replaced
+    void rebuildMasks() {
+        memset(rowUsed, 0, sizeof(rowUsed));
+        memset(colUsed, 0, sizeof(colUsed));
+        memset(boxUsed, 0, sizeof(boxUsed));
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board[cell] != 0) {
+                Mask digitMask = digitBit(board[cell]);
+                rowUsed[geo.rowOf[cell]] |= digitMask;
+                colUsed[geo.colOf[cell]] |= digitMask;
+                boxUsed[geo.boxOf[cell]] |= digitMask;
+            }
+        }
+    }
+
+    // Digits already used by the peers of a cell
+    Mask usedMask(int cell) const {
+        return rowUsed[geo.rowOf[cell]] | colUsed[geo.colOf[cell]] | boxUsed[geo.boxOf[cell]];
+    }
+
     // Helper function to check if a number can be placed at given position
-    bool isValid(int row, int col, int num) {
-        // Check row
-        for (int x = 0; x < N; x++) {
-            if (board[row][x] == num) return false;
-        }
-        
-        // Check column
-        for (int x = 0; x < N; x++) {
-            if (board[x][col] == num) return false;
-        }
-        
-        // Check 3x3 box
-        int startRow = row - row % 3;
-        int startCol = col - col % 3;
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                if (board[i + startRow][j + startCol] == num) return false;
-            }
-        }
-        
+    bool isValid(int row, int col, int num) const {
+        return (usedMask(row * N + col) & digitBit(num)) == 0;
+    }
+
+    uint64_t computeBoardHash() const {
+        uint64_t hash = 0;
+        for (int cell = 0; cell < CELLS; cell++) hash ^= zobristKeys<BoxSize>.keys[cell][board[cell]];
+        return hash;
+    }
+
+    // xorshift64*
+    uint64_t nextRandom() {
+        random_ ^= random_ >> 12;
+        random_ ^= random_ << 25;
+        random_ ^= random_ >> 27;
+        return random_ * 0x2545F4914F6CDD1Dull;
+    }
+
+    // Next digit to try in `cell` out of the nonzero `remaining`, by the
+    // value order. Peers' candidates come from `candidates` when given,
+    // else from the unit masks.
+    int nextDigit(int cell, Mask remaining, const Mask* candidates) {
+        ValueOrder order = heuristics_.valueOrder;
+        if (randomRun_ && order == VALUE_ORDER_ASCENDING) order = VALUE_ORDER_RANDOM;
+        if (order == VALUE_ORDER_ASCENDING || (remaining & (remaining - 1)) == 0) {
+            return __builtin_ctz(remaining) + 1;
+        }
+
+        if (order == VALUE_ORDER_RANDOM) {
+            for (int skip = nextRandom() % __builtin_popcount(remaining); skip > 0; skip--) {
+                remaining &= remaining - 1;
+            }
+            return __builtin_ctz(remaining) + 1;
+        }
+
+        // Least constraining: the digit left in the fewest open peers
+        int uses[N + 1] = {0};
+        for (int p = 0; p < Shape::PEERS; p++) {
+            int peer = geo.peers[cell][p];
+            if (board[peer] != 0) continue;
+            Mask peerCandidates = candidates ? candidates[peer] : (Mask)(Shape::ALL & ~usedMask(peer));
+            for (Mask shared = peerCandidates & remaining; shared != 0; shared &= shared - 1) {
+                uses[__builtin_ctz(shared) + 1]++;
+            }
+        }
+        int best = 0;
+        for (Mask left = remaining; left != 0; left &= left - 1) {
+            int digit = __builtin_ctz(left) + 1;
+            if (best == 0 || uses[digit] < uses[best]) best = digit;
+        }
+        return best;
+    }
+
+    // True once the current run has used up its restart budget
+    bool restartDue() {
+        if (restartLimit_ == 0 || stats_.nodes < restartLimit_) return false;
+        restarted_ = true;
         return true;
     }
-    
-    // Find empty cell (returns false if no empty cell found)
-    bool findEmptyCell(int& row, int& col) {
-        for (row = 0; row < N; row++) {
-            for (col = 0; col < N; col++) {
-                if (board[row][col] == 0) return true;
+
+    bool isNogood() {
+        if (heuristics_.nogoods == 0 || !nogoods_.contains(boardHash_)) return false;
+        if constexpr (SEARCH_STATS_ENABLED) stats_.nogoodPrunes++;
+        return true;
+    }
+
+    void recordNogood() {
+        if (heuristics_.nogoods > 0) nogoods_.add(boardHash_);
+    }
+
+    // Run a search under the heuristics' restart schedule. Each run after
+    // the first starts over from the board as it was, orders at random and
+    // gets restartGrowth times the node budget of the one before.
+    template <typename Run>
+    bool searchWithRestarts(Run run) {
+        random_ = heuristics_.seed * 0x9E3779B97F4A7C15ull + 0x2545F4914F6CDD1Dull;
+        if (heuristics_.nogoods > 0) boardHash_ = computeBoardHash();
+        randomRun_ = heuristics_.valueOrder == VALUE_ORDER_RANDOM;
+        if (heuristics_.restartNodes == 0) return run();
+
+        Grid start = board;
+        double budget = (double)heuristics_.restartNodes;
+        for (;;) {
+            restartLimit_ = stats_.nodes + (uint64_t)budget;
+            restarted_ = false;
+            bool solved = run();
+            if (!restarted_) {
+                restartLimit_ = 0;
+                return solved;
+            }
+            if constexpr (SEARCH_STATS_ENABLED) stats_.restarts++;
+            board = start;
+            rebuildMasks();
+            if (heuristics_.nogoods > 0) boardHash_ = computeBoardHash();
+            randomRun_ = true;
+            budget *= heuristics_.restartGrowth;
+        }
+    }
+
+    // Stats hooks, compiled away unless SUDOKU_STATS is defined
+    void recordDepth(int depth) {
+        if constexpr (SEARCH_STATS_ENABLED) {
+            if (depth > stats_.maxDepth) stats_.maxDepth = depth;
+        }
+    }
+
+    void recordBacktrack() {
+        if constexpr (SEARCH_STATS_ENABLED) stats_.backtracks++;
+    }
+
+    // Answer the board from the cache; true on a hit, with `solved` set and
+    // the solution mapped back onto the board
+    bool lookupCache(bool& solved) {
+        cacheHit_ = false;
+        if constexpr (BoxSize != 3) {
+            return false;
+        } else {
+            if (!cache_) return false;
+            // Sparse boards, and boards whose canonical search was cut, are
+            // solved without the cache
+            int clues = 0;
+            for (int cell = 0; cell < CELLS; cell++) clues += board[cell] != 0;
+            cacheKey_.exact = false;
+            if (clues < MIN_CACHED_CLUES) return false;
+            canonicalizeBoard(board.data(), cacheKey_);
+            if (!cacheKey_.exact) return false;
+            uint8_t solution[CELLS];
+            if (!cache_->lookup(cacheKey_.cells, solution, solved)) return false;
+            cacheHit_ = true;
+            stats_ = SearchStats();
+            if (solved) {
+                cacheKey_.transform.restore(solution, board.data());
+                rebuildMasks();
+            }
+            return true;
+        }
+    }
+
+    // Record the outcome of a solve that missed the cache (not a solve cut
+    // short by its limits)
+    void storeCache(bool solved) {
+        if constexpr (BoxSize == 3) {
+            if (!cache_ || budget_.stopped() || !cacheKey_.exact) return;
+            uint8_t solution[CELLS];
+            if (solved) cacheKey_.transform.apply(board.data(), solution);
+            cache_->store(cacheKey_.cells, solution, solved);
+        }
+    }
+
+    // Close the stats of a solve: everything not spent propagating is search
+    void finishStats(const StatsTimer& timer) {
+        if constexpr (SEARCH_STATS_ENABLED) {
+            stats_.searchSeconds = timer.seconds() - stats_.propagationSeconds;
+        }
+    }
+
+    // Constraint Propagation: remove the digits of filled peers from every
+    // empty cell's candidates, logging each changed mask on the trail
+    void propagateConstraints(SearchTrail& trail) {
+        StatsTimer timer;
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board[cell] != 0) continue;
+            Mask remaining = trail.candidates[cell] & ~usedMask(cell);
+            if (remaining == trail.candidates[cell]) continue;
+            trail.save(cell);
+            if constexpr (SEARCH_STATS_ENABLED) {
+                stats_.candidatesEliminated += __builtin_popcount(trail.candidates[cell] & ~remaining);
+            }
+            trail.candidates[cell] = remaining;
+        }
+
+        if constexpr (SEARCH_STATS_ENABLED) {
+            stats_.propagationPasses++;
+            stats_.propagationSeconds += timer.seconds();
+        }
+    }
+
+    // Backtracking over a precomputed list of empty cells (scan order)
+    // Fill emptyCells[0..count) in order, digits in the value order (lowest
+    // first by default). Iterative: the digits each level has left to try
+    // live in untried[], so depth costs no stack.
+    bool solveBacktrackingSearch(const Cell* emptyCells, Mask* untried, int count) {
+        int level = 0;
+        bool entering = true;
+        for (;;) {
+            if (entering) {
+                stats_.nodes++;
+                recordDepth(level);
+                if (budget_.exhausted(stats_.nodes) || restartDue()) {
+                    return false;
+                }
+
+                // If no empty cell, puzzle is solved
+                if (level == count) {
+                    return true;
+                }
+                untried[level] = Shape::ALL & ~usedMask(emptyCells[level]);
+                if (untried[level] != 0 && isNogood()) untried[level] = 0;
+            }
+
+            int cell = emptyCells[level];
+            if (board[cell] != 0) {
+                // Back from a dead end below: take the digit out again
+                unplace(cell);
+                recordBacktrack();
+            }
+
+            if (untried[level] != 0) {
+                int num = nextDigit(cell, untried[level], nullptr);
+                untried[level] &= ~digitBit(num);
+                place(cell, num);
+                level++;
+                entering = true;
+                continue;
+            }
+
+            // Every digit failed below this board
+            if (!entering) recordNogood();
+            if (level == 0) {
+                return false;
+            }
+            level--;
+            entering = false;
+        }
+    }
+
+    // Fill naked singles with the kernel, then run the enabled inference
+    // rules and repeat until neither finds anything. False on a contradiction.
+    bool propagate(CandidateGrid& grid, uint8_t* cells, RuleCounters* counters) const {
+        for (;;) {
+            if (!kernel_->propagate(grid, cells)) return false;
+            if (inferenceRules_ == 0) return true;
+            RuleOutcome outcome = InferenceEngine<BoxSize>::apply(grid, inferenceRules_, counters);
+            if (outcome != RULES_PROGRESS) return outcome == RULES_NO_PROGRESS;
+        }
+    }
+
+    // Candidates left on the open cells, for the elimination count
+    static int candidateCount(const CandidateGrid& grid) {
+        int count = 0;
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (grid.isOpen(cell)) count += __builtin_popcount(grid.cells[cell]);
+        }
+        return count;
+    }
+
+    // propagate() on the solver's board, with stats when compiled in. A cell
+    // filled by propagation keeps its digit, so only the others count as
+    // eliminated.
+    bool propagateBoard(CandidateGrid& grid) {
+        if constexpr (!SEARCH_STATS_ENABLED) {
+            return propagate(grid, board.data(), &ruleCounters_);
+        } else {
+            StatsTimer timer;
+            int before = candidateCount(grid), openBefore = 0, openAfter = 0;
+            for (int word = 0; word < CandidateGrid::WORDS; word++) openBefore += __builtin_popcountll(grid.open[word]);
+            bool consistent = propagate(grid, board.data(), &ruleCounters_);
+            for (int word = 0; word < CandidateGrid::WORDS; word++) openAfter += __builtin_popcountll(grid.open[word]);
+            int eliminated = before - candidateCount(grid) - (openBefore - openAfter);
+            stats_.candidatesEliminated += eliminated > 0 ? eliminated : 0;
+            stats_.propagationPasses++;
+            stats_.propagationSeconds += timer.seconds();
+            return consistent;
+        }
+    }
+
+    // Bitmask engine: one candidate mask per cell, copied by value on the
+    // call stack at each branch so the search never touches the heap. The
+    // kernel fills naked singles, which the set-based search would pick first
+    // anyway, so with every inference rule off both engines explore the same
+    // tree.
+    bool solveBitmaskHelper(const CandidateGrid& grid, int depth) {
+        stats_.nodes++;
+        recordDepth(depth);
+        if (budget_.exhausted(stats_.nodes)) {
+            return false;
+        }
+        int minCell = pickBranchCell(grid);
+
+        // If no empty cell, puzzle is solved
+        if (minCell == -1) {
+            return true;
+        }
+
+        // Try each candidate, lowest digit first
+        for (unsigned remaining = grid.cells[minCell]; remaining != 0; remaining &= remaining - 1) {
+            CandidateGrid next = grid;
+            next.cells[minCell] = (Mask)(remaining & -remaining);
+
+            if (propagateBoard(next) && solveBitmaskHelper(next, depth + 1)) {
+                return true;
+            }
+
+            // Backtrack: clear every cell this branch filled
+            clearFilled(grid, next);
+            recordBacktrack();
+            if (budget_.stopped()) {
+                break;
             }
         }
+
         return false;
     }
-    
-    // Constraint Propagation: Remove candidates based on filled cells
-    void propagateConstraints(vector<vector<set<int>>>& candidates) {
-        bool changed = true;
-        while (changed) {
-            changed = false;
-            
-            // For each cell
-            for (int i = 0; i < N; i++) {
-                for (int j = 0; j < N; j++) {
-                    if (board[i][j] != 0) continue;
-                    
-                    // Remove candidates based on row constraints
-                    for (int k = 0; k < N; k++) {
-                        if (board[i][k] != 0 && candidates[i][j].find(board[i][k]) != candidates[i][j].end()) {
-                            candidates[i][j].erase(board[i][k]);
-                            changed = true;
-                        }
-                    }
-                    
-                    // Remove candidates based on column constraints
-                    for (int k = 0; k < N; k++) {
-                        if (board[k][j] != 0 && candidates[i][j].find(board[k][j]) != candidates[i][j].end()) {
-                            candidates[i][j].erase(board[k][j]);
-                            changed = true;
-                        }
-                    }
-                    
-                    // Remove candidates based on 3x3 box constraints
-                    int startRow = i - i % 3;
-                    int startCol = j - j % 3;
-                    for (int r = startRow; r < startRow + 3; r++) {
-                        for (int c = startCol; c < startCol + 3; c++) {
-                            if (board[r][c] != 0 && candidates[i][j].find(board[r][c]) != candidates[i][j].end()) {
-                                candidates[i][j].erase(board[r][c]);
-                                changed = true;
-                            }
-                        }
-                    }
+
+    // Find cell with minimum candidates (first in scan order on ties);
+    // -1 once every cell is filled
+    int pickBranchCell(const CandidateGrid& grid) const {
+        int minCandidates = N + 1;
+        int minCell = -1;
+
+        for (int word = 0; word < CandidateGrid::WORDS; word++) {
+            for (uint64_t bits = grid.open[word]; bits != 0; bits &= bits - 1) {
+                int cell = word * 64 + __builtin_ctzll(bits);
+                int count = __builtin_popcount(grid.cells[cell]);
+                if (count < minCandidates) {
+                    minCandidates = count;
+                    minCell = cell;
+                }
+            }
+        }
+
+        return minCell;
+    }
+
+    // Candidate grid of the current board (givens are assumed consistent)
+    CandidateGrid buildCandidateGrid() const {
+        CandidateGrid grid;
+        memset(&grid, 0, sizeof(grid));
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board[cell] == 0) {
+                grid.cells[cell] = Shape::ALL & ~usedMask(cell);
+                grid.open[cell >> 6] |= 1ull << (cell & 63);
+            }
+        }
+        return grid;
+    }
+
+    // Count solutions below a node until `found` reaches `limit` or the
+    // budget runs out (`nodes` counts the nodes it is checked against).
+    // Works on a scratch board so the solver's own board is never touched.
+    void countSolutionsHelper(const CandidateGrid& grid, uint8_t* scratch, size_t limit,
+                              atomic<size_t>& found, RuleCounters* counters,
+                              SolveBudget& budget, uint64_t& nodes) const {
+        if (budget.exhausted(++nodes)) return;
+        int cell = pickBranchCell(grid);
+        if (cell == -1) {
+            found.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        for (unsigned remaining = grid.cells[cell]; remaining != 0; remaining &= remaining - 1) {
+            if (found.load(memory_order_relaxed) >= limit || budget.stopped()) return;
+
+            CandidateGrid next = grid;
+            next.cells[cell] = (Mask)(remaining & -remaining);
+            if (propagate(next, scratch, counters)) {
+                countSolutionsHelper(next, scratch, limit, found, counters, budget, nodes);
+            }
+        }
+    }
+
+    // Split the tree breadth-first into independent subtrees, then count
+    // them on `threads` workers that share one cut-off counter. Each worker
+    // checks the limits on its own budget, so a node budget is per worker.
+    SolveStatus countSolutionsParallel(const CandidateGrid& root, size_t limit, int threads,
+                                       const SolveLimits& limits, size_t& count) const {
+        atomic<size_t> found(0);
+        uint8_t scratch[CELLS];
+
+        deque<CandidateGrid> frontier(1, root);
+        size_t target = (size_t)threads * 8;
+        while (!frontier.empty() && frontier.size() < target && found.load() < limit) {
+            CandidateGrid node = frontier.front();
+            frontier.pop_front();
+
+            int cell = pickBranchCell(node);
+            if (cell == -1) {
+                found++;
+                continue;
+            }
+            for (unsigned remaining = node.cells[cell]; remaining != 0; remaining &= remaining - 1) {
+                CandidateGrid next = node;
+                next.cells[cell] = (Mask)(remaining & -remaining);
+                if (propagate(next, scratch, &ruleCounters_)) {
+                    frontier.push_back(next);
+                }
+            }
+        }
+
+        // Each worker counts rule firings on its own, merged after the join
+        vector<CandidateGrid> subtrees(frontier.begin(), frontier.end());
+        vector<RuleCounters> workerCounters(threads);
+        vector<SolveBudget> workerBudgets(threads);
+        atomic<size_t> nextSubtree(0);
+        vector<thread> workers;
+        for (int w = 0; w < threads; w++) {
+            workers.push_back(thread([&, w]() {
+                uint8_t workerScratch[CELLS];
+                uint64_t nodes = 0;
+                workerBudgets[w].start(limits);
+                for (;;) {
+                    size_t i = nextSubtree.fetch_add(1);
+                    if (i >= subtrees.size() || found.load(memory_order_relaxed) >= limit) break;
+                    countSolutionsHelper(subtrees[i], workerScratch, limit, found, &workerCounters[w],
+                                         workerBudgets[w], nodes);
+                    if (workerBudgets[w].stopped()) break;
                 }
+            }));
+        }
+        for (size_t w = 0; w < workers.size(); w++) {
+            workers[w].join();
+            ruleCounters_.add(workerCounters[w]);
+        }
+
+        count = min(found.load(), limit);
+        if (count >= limit) return SOLVE_SOLVED;
+        for (int w = 0; w < threads; w++) {
+            if (workerBudgets[w].stopped()) return workerBudgets[w].reason();
+        }
+        return SOLVE_SOLVED;
+    }
+
+    // Empty the cells that are open in `before` but filled in `after`
+    void clearFilled(const CandidateGrid& before, const CandidateGrid& after) {
+        for (int word = 0; word < CandidateGrid::WORDS; word++) {
+            for (uint64_t bits = before.open[word] & ~after.open[word]; bits != 0; bits &= bits - 1) {
+                board[word * 64 + __builtin_ctzll(bits)] = 0;
             }
         }
     }
 
 public:
-    SudokuSolver() {
-        board = vector<vector<int>>(N, vector<int>(N, 0));
+    BasicSudokuSolver()
+        : kernel_(&propagationKernel<BoxSize>()), inferenceRules_(ALL_INFERENCE_RULES),
+          searchThreads_(1), split_(nullptr), splitWorker_(0), cache_(nullptr), cacheHit_(false), boardHash_(0), random_(0),
+          randomRun_(false), restartLimit_(0), restarted_(false), routing_(defaultAutoRouting<BoxSize>()),
+          lastRoute_(ROUTE_SINGLES), routeCounts_() {
+        board.fill(0);
+        rebuildMasks();
     }
-    
-    // Set the board
+
+    // Set the board (nested-vector adapter)
     void setBoard(const vector<vector<int>>& newBoard) {
-        board = newBoard;
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < N; j++) {
+                board[i * N + j] = newBoard[i][j];
+            }
+        }
+        rebuildMasks();
+    }
+
+    // Set the board from the flat layout
+    void setBoard(Grid newBoard) {
+        board = move(newBoard);
+        rebuildMasks();
+    }
+
+    // Set the board from CELLS contiguous cells
+    void setBoard(const uint8_t* cells) {
+        memcpy(board.data(), cells, CELLS);
+        rebuildMasks();
     }
-    
-    // Get the board
+
+    // Get the board (nested-vector adapter)
     vector<vector<int>> getBoard() const {
+        vector<vector<int>> result(N, vector<int>(N));
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < N; j++) {
+                result[i][j] = board[i * N + j];
+            }
+        }
+        return result;
+    }
+
+    // Get the board in the flat layout without copying
+    const Grid& getGrid() const {
         return board;
     }
-    
+
     // Print the board
     void printBoard() const {
-        cout << "\n┌─────────┬─────────┬─────────┐\n";
+        string segment;
+        for (int k = 0; k < 2 * BoxSize + 3; k++) segment += "─";
+        string top = "┌", middle = "├", bottom = "└";
+        for (int b = 0; b < BoxSize; b++) {
+            top += segment + (b + 1 < BoxSize ? "┬" : "┐");
+            middle += segment + (b + 1 < BoxSize ? "┼" : "┤");
+            bottom += segment + (b + 1 < BoxSize ? "┴" : "┘");
+        }
+
+        cout << "\n" << top << "\n";
         for (int i = 0; i < N; i++) {
-            if (i > 0 && i % 3 == 0) {
-                cout << "├─────────┼─────────┼─────────┤\n";
+            if (i > 0 && i % BoxSize == 0) {
+                cout << middle << "\n";
             }
             cout << "│ ";
             for (int j = 0; j < N; j++) {
-                if (j > 0 && j % 3 == 0) cout << "│ ";
-                if (board[i][j] == 0) {
+                if (j > 0 && j % BoxSize == 0) cout << "│ ";
+                if (board[i * N + j] == 0) {
                     cout << "· ";
                 } else {
-                    cout << board[i][j] << " ";
+                    cout << DIGIT_SYMBOLS[board[i * N + j] - 1] << " ";
                 }
             }
             cout << "│\n";
         }
-        cout << "└─────────┴─────────┴─────────┘\n";
+        cout << bottom << "\n";
     }
-    
+
     // Backtracking Algorithm (Classic DSA approach)
     bool solveBacktracking() {
-        int row, col;
-        
-        // If no empty cell, puzzle is solved
-        if (!findEmptyCell(row, col)) {
-            return true;
-        }
-        
-        // Try digits 1 to 9
-        for (int num = 1; num <= 9; num++) {
-            if (isValid(row, col, num)) {
-                board[row][col] = num;
-                
-                if (solveBacktracking()) {
-                    return true;
-                }
-                
-                // If placing num doesn't lead to solution, backtrack
-                board[row][col] = 0;
-            }
+        bool solved;
+        if (lookupCache(solved)) return solved;
+        stats_ = SearchStats();
+        StatsTimer timer;
+
+        // Empty cells in scan order, so no level rescans the board, and the
+        // digits each level has left
+        Cell emptyCells[CELLS];
+        Mask untried[CELLS];
+        int count = 0;
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board[cell] == 0) emptyCells[count++] = cell;
         }
-        
-        return false;
+
+        solved = searchWithRestarts([&]() { return solveBacktrackingSearch(emptyCells, untried, count); });
+        finishStats(timer);
+        storeCache(solved);
+        return solved;
     }
-    
+
     // Constraint Propagation with Backtracking (Advanced DSA approach)
     bool solveConstraintPropagation() {
-        // Initialize candidates for all empty cells
-        vector<vector<set<int>>> candidates(N, vector<set<int>>(N));
-        for (int i = 0; i < N; i++) {
-            for (int j = 0; j < N; j++) {
-                if (board[i][j] == 0) {
-                    for (int num = 1; num <= 9; num++) {
-                        candidates[i][j].insert(num);
-                    }
-                }
+        bool solved;
+        if (lookupCache(solved)) return solved;
+        stats_ = SearchStats();
+        StatsTimer timer;
+
+        if (searchThreads_ > 1) {
+            solved = solveConstraintPropagationSplit();
+            finishStats(timer);
+            storeCache(solved);
+            return solved;
+        }
+
+        if (!trail_) {
+            trail_.reset(new SearchTrail());
+        }
+
+        // Initialize candidates for all empty cells on every run
+        SearchTrail& trail = *trail_;
+        solved = searchWithRestarts([&]() {
+            trail.size = 0;
+            for (int cell = 0; cell < CELLS; cell++) {
+                trail.candidates[cell] = board[cell] == 0 ? Shape::ALL : 0;
             }
+            return solveConstraintPropagationSearch(trail);
+        });
+        finishStats(timer);
+        storeCache(solved);
+        return solved;
+    }
+
+    // Constraint Propagation on bitmasks (same search order, no heap allocation)
+    bool solveBitmask() {
+        bool solved;
+        if (lookupCache(solved)) return solved;
+        stats_ = SearchStats();
+        StatsTimer timer;
+        CandidateGrid grid = buildCandidateGrid();
+
+        CandidateGrid start = grid;
+        solved = propagateBoard(grid) && solveBitmaskHelper(grid, 0);
+        if (solved) {
+            rebuildMasks();
+        } else {
+            clearFilled(start, grid);
         }
-        
-        return solveConstraintPropagationHelper(candidates);
+        finishStats(timer);
+        storeCache(solved);
+        return solved;
     }
-    
-private:
-    bool solveConstraintPropagationHelper(vector<vector<set<int>>>& candidates) {
-        // Propagate constraints
-        propagateConstraints(candidates);
-        
-        // Find cell with minimum candidates
-        int minCandidates = 10;
-        int minRow = -1, minCol = -1;
-        
-        for (int i = 0; i < N; i++) {
-            for (int j = 0; j < N; j++) {
-                if (board[i][j] == 0 && candidates[i][j].size() < minCandidates) {
-                    minCandidates = candidates[i][j].size();
-                    minRow = i;
-                    minCol = j;
-                }
-            }
+
+    // Count the solutions of the current board, stopping as soon as `limit`
+    // are found (limit 2 is the uniqueness check). With threads > 1 the
+    // top-level branches are split across threads. The board is unchanged.
+    size_t countSolutions(size_t limit = 2, int threads = 1) const {
+        size_t count;
+        countSolutionsWithLimits(limit, SolveLimits(), count, threads);
+        return count;
+    }
+
+    // countSolutions under limits. SOLVE_SOLVED when the count finished,
+    // with `count` set (0 included); SOLVE_TIMED_OUT or SOLVE_CANCELLED when
+    // a limit stopped it first, with `count` the solutions found until then.
+    SolveStatus countSolutionsWithLimits(size_t limit, const SolveLimits& limits, size_t& count,
+                                         int threads = 1) const {
+        count = 0;
+        if (limit == 0 || hasConflicts()) {
+            return SOLVE_SOLVED;
         }
-        
-        // If no empty cell, puzzle is solved
-        if (minRow == -1) {
-            return true;
+
+        uint8_t scratch[CELLS];
+        CandidateGrid root = buildCandidateGrid();
+        if (!propagate(root, scratch, &ruleCounters_)) {
+            return SOLVE_SOLVED;
         }
-        
-        // If a cell has no candidates, this branch is invalid
-        if (candidates[minRow][minCol].empty()) {
-            return false;
+
+        if (threads > 1) {
+            return countSolutionsParallel(root, limit, threads, limits, count);
         }
-        
-        // Try each candidate for the cell with minimum candidates
-        set<int> currentCandidates = candidates[minRow][minCol];
-        for (int num : currentCandidates) {
-            if (isValid(minRow, minCol, num)) {
-                board[minRow][minCol] = num;
-                
-                // Create new candidates state
-                vector<vector<set<int>>> newCandidates = candidates;
-                newCandidates[minRow][minCol].clear();
-                
-                if (solveConstraintPropagationHelper(newCandidates)) {
-                    return true;
+
+        atomic<size_t> found(0);
+        SolveBudget budget;
+        uint64_t nodes = 0;
+        budget.start(limits);
+        countSolutionsHelper(root, scratch, limit, found, &ruleCounters_, budget, nodes);
+        count = min(found.load(), limit);
+        return count < limit && budget.stopped() ? budget.reason() : SOLVE_SOLVED;
+    }
+
+    // True if the current board has exactly one solution
+    bool hasUniqueSolution() const {
+        return countSolutions(2) == 1;
+    }
+
+    // True if the current board has a solution with `num` kept out of the
+    // empty cell `cell`. When the board had one solution with `num` there
+    // before the cell was cleared, false means it is still unique; one
+    // search for any solution is cheaper than counting to two.
+    bool hasSolutionAvoiding(int cell, int num) const {
+        return searchSolutionAvoiding(cell, num, SolveLimits()) == SOLVE_SOLVED;
+    }
+
+    // hasSolutionAvoiding under limits: SOLVE_SOLVED if there is such a
+    // solution, SOLVE_UNSOLVABLE if not, or the limit that stopped the search
+    SolveStatus searchSolutionAvoiding(int cell, int num, const SolveLimits& limits) const {
+        if (board[cell] != 0 || hasConflicts()) {
+            return SOLVE_UNSOLVABLE;
+        }
+
+        uint8_t scratch[CELLS];
+        CandidateGrid root = buildCandidateGrid();
+        root.cells[cell] &= ~digitBit(num);
+        if (root.cells[cell] == 0 || !propagate(root, scratch, &ruleCounters_)) {
+            return SOLVE_UNSOLVABLE;
+        }
+
+        atomic<size_t> found(0);
+        SolveBudget budget;
+        uint64_t nodes = 0;
+        budget.start(limits);
+        countSolutionsHelper(root, scratch, 1, found, &ruleCounters_, budget, nodes);
+        if (found.load() > 0) return SOLVE_SOLVED;
+        return budget.stopped() ? budget.reason() : SOLVE_UNSOLVABLE;
+    }
+
+    // Choose the inference rules run at every node of the bitmask and
+    // counting searches: a mask of (1 << InferenceRule) bits, 0 for naked
+    // singles only. All rules are on by default.
+    void setInferenceRules(unsigned rules) {
+        inferenceRules_ = rules & ALL_INFERENCE_RULES;
+    }
+
+    unsigned getInferenceRules() const {
+        return inferenceRules_;
+    }
+
+    // Split the constraint engine's search across this many threads (1 to
+    // search on the calling thread). Idle threads steal the untried branches
+    // nearest the root, so one hard puzzle gets every core.
+    void setSearchThreads(int threads) {
+        searchThreads_ = max(1, threads);
+    }
+
+    int getSearchThreads() const {
+        return searchThreads_;
+    }
+
+    // Cells changed by each rule since the last reset
+    const RuleCounters& getRuleCounters() const {
+        return ruleCounters_;
+    }
+
+    void resetRuleCounters() {
+        ruleCounters_ = RuleCounters();
+    }
+
+    // Search nodes visited by the last solve, for any engine
+    uint64_t getNodeCount() const {
+        return stats_.nodes;
+    }
+
+    // Counters of the last solve. Only the node count is kept unless the
+    // solver is built with SUDOKU_STATS; toJson() gives a JSON object.
+    const SearchStats& getSearchStats() const {
+        return stats_;
+    }
+
+    // Run one of the solve entry points under limits: a deadline, a node
+    // budget and/or a cancellation token another thread can trigger. A solve
+    // that times out or is cancelled leaves the board as it was.
+    SolveStatus solveWithLimits(bool (BasicSudokuSolver::*engine)(), const SolveLimits& limits) {
+        Grid original = board;
+        budget_.start(limits);
+        bool solved = (this->*engine)();
+        SolveStatus status = solved ? SOLVE_SOLVED : budget_.stopped() ? budget_.reason() : SOLVE_UNSOLVABLE;
+        budget_.clear();
+        if (status == SOLVE_TIMED_OUT || status == SOLVE_CANCELLED) {
+            board = original;
+            rebuildMasks();
+        }
+        return status;
+    }
+
+    // Put a shared solved-puzzle cache in front of the solve entry points
+    // (nullptr to turn it off). Only 9x9 boards are cached; the cache must
+    // outlive the solver. A hit restores the board and reports zero nodes.
+    void setSolutionCache(SolutionCache* cache) {
+        cache_ = cache;
+        cacheHit_ = false;
+    }
+
+    SolutionCache* getSolutionCache() const {
+        return cache_;
+    }
+
+    // Whether the last solve since setSolutionCache was answered by the
+    // cache rather than searched
+    bool wasCacheHit() const {
+        return cacheHit_;
+    }
+
+    // Value order, restarts and nogoods of the backtracking and constraint
+    // engines (not the split search). Changing the nogood capacity empties
+    // the store; otherwise what it learned carries over to the next solve.
+    void setSearchHeuristics(const SearchHeuristics& heuristics) {
+        if (heuristics.nogoods != heuristics_.nogoods) nogoods_.reset(heuristics.nogoods);
+        heuristics_ = heuristics;
+    }
+
+    const SearchHeuristics& getSearchHeuristics() const {
+        return heuristics_;
+    }
+
+    const NogoodStore& getNogoods() const {
+        return nogoods_;
+    }
+
+    // Name of the propagation kernel in use (scalar, sse2 or avx2)
+    const char* propagationKernelName() const {
+        return kernel_->name;
+    }
+
+    // Fill the naked singles the board forces, measuring the puzzle on the
+    // way (see PuzzleFeatures). Leaves the singles on the board, even when
+    // they run into a contradiction.
+    PuzzleFeatures propagateSingles() {
+        PuzzleFeatures features;
+        features.cells = CELLS;
+        features.digits = N;
+        CandidateGrid grid = buildCandidateGrid();
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board[cell] != 0) features.clues++;
+        }
+        features.candidates = candidateCount(grid);
+        features.contradiction = !kernel_->propagate(grid, board.data());
+        for (int word = 0; word < CandidateGrid::WORDS; word++) features.open += __builtin_popcountll(grid.open[word]);
+        features.singles = CELLS - features.clues - features.open;
+        features.openCandidates = candidateCount(grid);
+        rebuildMasks();
+        return features;
+    }
+
+    // Auto engine: fill the forced singles, then hand what is left to the
+    // engine the routing picks from the puzzle's features, so trivial
+    // puzzles skip the heavy engines' setup and hard ones the naive search
+    bool solveAuto() {
+        bool solved;
+        if (lookupCache(solved)) {
+            features_ = PuzzleFeatures();
+            lastRoute_ = ROUTE_CACHE;
+            routeCounts_[lastRoute_]++;
+            return solved;
+        }
+        Grid start = board;
+        features_ = propagateSingles();
+        lastRoute_ = routing_.route(features_);
+        routeCounts_[lastRoute_]++;
+
+        // The cache is keyed on the puzzle as given, not on the reduced board
+        SolutionCache* cache = cache_;
+        cache_ = nullptr;
+        switch (lastRoute_) {
+            case ROUTE_SINGLES:
+                stats_ = SearchStats();
+                solved = !features_.contradiction;
+                break;
+            case ROUTE_BACKTRACKING: solved = solveBacktracking(); break;
+            case ROUTE_BITMASK: solved = solveBitmask(); break;
+            default: solved = solveDancingLinks(); break;
+        }
+        cache_ = cache;
+        if (!solved) {
+            board = start;
+            rebuildMasks();
+        }
+        storeCache(solved);
+        return solved;
+    }
+
+    void setAutoRouting(const AutoRouting& routing) {
+        routing_ = routing;
+    }
+
+    const AutoRouting& getAutoRouting() const {
+        return routing_;
+    }
+
+    // Features and route of the last puzzle the auto engine solved; a cache
+    // hit has route ROUTE_CACHE and empty features
+    const PuzzleFeatures& getPuzzleFeatures() const {
+        return features_;
+    }
+
+    SolveRoute getLastRoute() const {
+        return lastRoute_;
+    }
+
+    // Puzzles the auto engine sent down a route since construction
+    uint64_t getRouteCount(SolveRoute route) const {
+        return routeCounts_[route];
+    }
+
+    // Dancing Links (Algorithm X) exact-cover search
+    bool solveDancingLinks() {
+        bool found;
+        if (lookupCache(found)) return found;
+        if (!dlx_) {
+            dlx_.reset(new BasicDancingLinks<BoxSize>());
+            dlx_->setBudget(&budget_);
+        }
+        found = dlx_->solve(board.data());
+        stats_ = dlx_->searchStats();
+        if (found) {
+            rebuildMasks();
+        }
+        storeCache(found);
+        return found;
+    }
+
+private:
+    // Search on the trail's candidate masks. Each node propagates, then
+    // branches on the empty cell with the fewest candidates (first in
+    // reading order, or a random one in a random run), digits in the value
+    // order. A board known to be a dead end is not expanded, and one whose
+    // every digit failed is recorded as one. A frame per open branch and the
+    // trail of changed masks replace the recursion and the per-branch copies
+    // of the candidates: backing up restores just the masks logged since the
+    // branch was taken.
+    bool solveConstraintPropagationSearch(SearchTrail& trail) {
+        int depth = 0;
+        for (;;) {
+            stats_.nodes++;
+            recordDepth(depth);
+            if (budget_.exhausted(stats_.nodes) || restartDue()) {
+                trail.undo(0);
+                return false;
+            }
+            propagateConstraints(trail);
+
+            // Find cell with minimum candidates
+            int minCell = -1, minCandidates = N + 1, ties = 0;
+            for (int cell = 0; cell < CELLS; cell++) {
+                if (board[cell] != 0) continue;
+                int candidates = __builtin_popcount(trail.candidates[cell]);
+                if (candidates < minCandidates) {
+                    minCandidates = candidates;
+                    minCell = cell;
+                    ties = 1;
+                } else if (randomRun_ && candidates == minCandidates && nextRandom() % ++ties == 0) {
+                    minCell = cell;
+                }
+            }
+
+            // If no empty cell, puzzle is solved
+            if (minCell == -1) {
+                return true;
+            }
+
+            // A cell without candidates, or a known dead end, ends this
+            // branch; otherwise open one
+            if (minCandidates > 0 && !isNogood()) {
+                typename SearchTrail::Frame& frame = trail.frames[depth];
+                frame.cell = minCell;
+                frame.remaining = trail.candidates[minCell];
+                frame.mark = trail.size;
+                depth++;
+            }
+
+            // Take the next untried digit of the deepest open branch
+            for (;;) {
+                if (depth == 0) {
+                    trail.undo(0);
+                    return false;
+                }
+                typename SearchTrail::Frame& frame = trail.frames[depth - 1];
+                if (board[frame.cell] != 0) {
+                    unplace(frame.cell);
+                    recordBacktrack();
                 }
-                
-                // Backtrack
-                board[minRow][minCol] = 0;
+                trail.undo(frame.mark);
+                if (frame.remaining != 0) {
+                    int num = nextDigit(frame.cell, frame.remaining, trail.candidates);
+                    frame.remaining &= ~digitBit(num);
+                    place(frame.cell, num);
+                    break;
+                }
+                recordNogood();
+                depth--;
+            }
+            if (split_ && split_->idle.load(memory_order_relaxed) > split_->queued.load(memory_order_relaxed)) {
+                shareWork(trail, depth);
             }
         }
-        
-        return false;
     }
-    
-public:
-    // Check if the board is valid
-    bool isValidBoard() const {
-        // Check rows
-        for (int i = 0; i < N; i++) {
-            set<int> row;
-            for (int j = 0; j < N; j++) {
-                if (board[i][j] != 0) {
-                    if (row.find(board[i][j]) != row.end()) return false;
-                    row.insert(board[i][j]);
+
+    // Give the untried digits of the shallowest open branch to the idle
+    // workers as a subproblem: the board and masks as they were when that
+    // branch opened, with the branch cell limited to those digits
+    void shareWork(SearchTrail& trail, int depth) {
+        int shallowest = 0;
+        while (shallowest < depth && trail.frames[shallowest].remaining == 0) shallowest++;
+        if (shallowest == depth) return;
+        typename SearchTrail::Frame& frame = trail.frames[shallowest];
+
+        typename SplitSearch::Subproblem subproblem;
+        subproblem.board = board;
+        for (int level = shallowest; level < depth; level++) {
+            subproblem.board[trail.frames[level].cell] = 0;
+        }
+        memcpy(subproblem.candidates, trail.candidates, sizeof(subproblem.candidates));
+        for (uint32_t i = trail.size; i > frame.mark; i--) {
+            subproblem.candidates[trail.changes[i - 1].cell] = trail.changes[i - 1].mask;
+        }
+        subproblem.candidates[frame.cell] = frame.remaining;
+        frame.remaining = 0;
+        split_->push(splitWorker_, subproblem);
+    }
+
+    // One worker of a split search: search subproblems, its own first, then
+    // stolen ones, until a worker solves the puzzle or no work is left
+    void runSplitWorker(SplitSearch& split, int worker) {
+        split_ = &split;
+        splitWorker_ = worker;
+        stats_ = SearchStats();
+        if (!trail_) {
+            trail_.reset(new SearchTrail());
+        }
+        SearchTrail& trail = *trail_;
+
+        typename SplitSearch::Subproblem subproblem;
+        while (!split.stop.isCancelled()) {
+            if (!split.take(worker, subproblem)) {
+                split.idle++;
+                bool found = false;
+                while (!found && split.waitForWork()) {
+                    found = split.take(worker, subproblem);
                 }
+                split.idle--;
+                if (!found) break;
             }
-        }
-        
-        // Check columns
-        for (int j = 0; j < N; j++) {
-            set<int> col;
-            for (int i = 0; i < N; i++) {
-                if (board[i][j] != 0) {
-                    if (col.find(board[i][j]) != col.end()) return false;
-                    col.insert(board[i][j]);
+
+            board = subproblem.board;
+            rebuildMasks();
+            memcpy(trail.candidates, subproblem.candidates, sizeof(trail.candidates));
+            trail.size = 0;
+            budget_.start(split.limits);
+            bool solved = solveConstraintPropagationSearch(trail);
+            {
+                lock_guard<mutex> guard(split.resultLock);
+                if (solved && !split.solved) {
+                    split.solved = true;
+                    split.solution = board;
+                } else if (!solved && budget_.stopped() && !split.solved && !split.limited) {
+                    split.limited = true;
+                    split.limitReason = budget_.reason();
                 }
             }
+            if (solved || budget_.stopped()) split.stop.cancel();
+            budget_.clear();
+            if (--split.pending == 0 || split.stop.isCancelled()) split.wake(true);
         }
-        
-        // Check 3x3 boxes
-        for (int box = 0; box < N; box++) {
-            set<int> boxSet;
-            int startRow = (box / 3) * 3;
-            int startCol = (box % 3) * 3;
-            for (int i = startRow; i < startRow + 3; i++) {
-                for (int j = startCol; j < startCol + 3; j++) {
-                    if (board[i][j] != 0) {
-                        if (boxSet.find(board[i][j]) != boxSet.end()) return false;
-                        boxSet.insert(board[i][j]);
-                    }
-                }
+        split_ = nullptr;
+    }
+
+    // Constraint search on searchThreads_ workers, each with a solver of its
+    // own. Any limits of the running solve apply to every worker (a node
+    // budget per worker); the first worker to solve the puzzle, or to hit a
+    // limit, stops the rest.
+    bool solveConstraintPropagationSplit() {
+        SplitSearch split(searchThreads_);
+        split.limits = budget_.limits();
+        split.stop.link(split.limits.token);
+        split.limits.token = &split.stop;
+
+        typename SplitSearch::Subproblem root;
+        root.board = board;
+        for (int cell = 0; cell < CELLS; cell++) {
+            root.candidates[cell] = board[cell] == 0 ? Shape::ALL : 0;
+        }
+        split.push(0, root);
+
+        vector<unique_ptr<BasicSudokuSolver>> solvers;
+        vector<thread> workers;
+        for (int w = 0; w < searchThreads_; w++) {
+            solvers.push_back(unique_ptr<BasicSudokuSolver>(new BasicSudokuSolver()));
+        }
+        for (int w = 0; w < searchThreads_; w++) {
+            workers.push_back(thread([&, w]() {
+                solvers[w]->runSplitWorker(split, w);
+            }));
+        }
+        for (int w = 0; w < searchThreads_; w++) {
+            workers[w].join();
+            const SearchStats& worker = solvers[w]->stats_;
+            stats_.nodes += worker.nodes;
+            if constexpr (SEARCH_STATS_ENABLED) {
+                stats_.backtracks += worker.backtracks;
+                stats_.maxDepth = max(stats_.maxDepth, worker.maxDepth);
+                stats_.propagationPasses += worker.propagationPasses;
+                stats_.candidatesEliminated += worker.candidatesEliminated;
             }
         }
-        
-        return true;
+
+        if (split.solved) {
+            board = split.solution;
+            rebuildMasks();
+            return true;
+        }
+        if (split.limited) {
+            budget_.stop(split.limitReason);
+        } else if (split.stop.isCancelled()) {
+            budget_.stop(SOLVE_CANCELLED);       // cancelled before any work started
+        }
+        return false;
+    }
+
+public:
+    // True if two givens share a digit within a row, column or box
+    bool hasConflicts() const {
+        Mask rows[N] = {0}, cols[N] = {0}, boxes[N] = {0};
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board[cell] == 0) continue;
+            Mask digitMask = digitBit(board[cell]);
+            Mask& row = rows[geo.rowOf[cell]];
+            Mask& col = cols[geo.colOf[cell]];
+            Mask& box = boxes[geo.boxOf[cell]];
+            if ((row | col | box) & digitMask) return true;
+            row |= digitMask;
+            col |= digitMask;
+            box |= digitMask;
+        }
+        return false;
+    }
+
+    // Check if the board is valid: no digit repeats within a row, column
+    // or box (empty cells are fine). For many grids at once, see
+    // validateGrids in GridValidator.cpp.
+    bool isValidBoard() const {
+        return !hasConflicts();
     }
-    
+
     // Check if the board is complete
     bool isComplete() const {
-        for (int i = 0; i < N; i++) {
-            for (int j = 0; j < N; j++) {
-                if (board[i][j] == 0) return false;
-            }
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (board[cell] == 0) return false;
         }
         return true;
     }
-}; 
\ No newline at end of file
+};
+
+// The classic 9x9 solver, plus the larger grid sizes
+typedef BasicSudokuSolver<3> SudokuSolver;
+typedef BasicSudokuSolver<4> SudokuSolver16;
+typedef BasicSudokuSolver<5> SudokuSolver25;
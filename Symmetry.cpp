@@ -0,0 +1,289 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Symmetries of the 9x9 board: transposition, permuting the three bands and
+// the rows within each band, permuting the three stacks and the columns
+// within each stack, and relabeling the digits. Equivalent puzzles have the
+// same solution count and solutions that map onto each other.
+
+// One symmetry: canonical cell (r, c) holds digits[source(rows[r], cols[c])],
+// read from the transposed board when `transpose` is set
+struct BoardTransform {
+    bool transpose;
+    uint8_t rows[9];
+    uint8_t cols[9];
+    uint8_t digits[10];                      // digits[0] stays 0 (empty)
+
+    // Cell of the original board behind canonical cell (r, c)
+    int source(int r, int c) const {
+        return transpose ? cols[c] * 9 + rows[r] : rows[r] * 9 + cols[c];
+    }
+
+    // Original board -> canonical orientation
+    void apply(const uint8_t* board, uint8_t* canonical) const {
+        for (int r = 0; r < 9; r++) {
+            for (int c = 0; c < 9; c++) {
+                canonical[r * 9 + c] = digits[board[source(r, c)]];
+            }
+        }
+    }
+
+    // Canonical orientation -> original board
+    void restore(const uint8_t* canonical, uint8_t* board) const {
+        uint8_t inverse[10];
+        for (int d = 0; d <= 9; d++) inverse[digits[d]] = d;
+        for (int r = 0; r < 9; r++) {
+            for (int c = 0; c < 9; c++) {
+                board[source(r, c)] = inverse[canonical[r * 9 + c]];
+            }
+        }
+    }
+};
+
+// Canonical representative of a board's symmetry class and the transform
+// that produces it
+struct CanonicalBoard {
+    uint8_t cells[81];
+    BoardTransform transform;
+    bool exact;                              // false if the tie search was cut: cells and transform unset
+};
+
+// Canonical form: the image of the board that is smallest row by row, with
+// digits relabeled 1, 2, 3... in reading order and empty cells ordered after
+// every digit (so clue-heavy rows come first and pin the columns early).
+//
+// The rows are fixed one at a time. Each search state is a transposition, a
+// column order and the rows placed so far; a state only survives a step if
+// its next row ties the smallest one seen, so the states left after row 9
+// all give the minimum. Boards with many empty rows tie across huge numbers
+// of column orders, and following them all costs far more than solving such
+// a board; once the tie set outgrows MAX_STATES the search stops and the
+// board is reported as having no exact canonical form.
+class BoardCanonicalizer {
+private:
+    static const size_t MAX_STATES = 1 << 11;
+
+    struct State {
+        uint16_t columnOrder;                // index into columnOrders()
+        uint8_t transpose;
+        uint8_t placed;                      // rows fixed so far
+        uint16_t usedRows;
+        uint8_t rows[9];
+        uint8_t digits[10];
+        uint8_t nextLabel;
+    };
+
+    // The six orders of three things, in lexicographic order
+    static const uint8_t (*permutations())[3] {
+        static const uint8_t perms[6][3] = {
+            {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+        };
+        return perms;
+    }
+
+    // The 1296 column orders: stack order times the order within each
+    // stack, indexed ((s * 6 + a) * 6 + b) * 6 + c
+    static const vector<array<uint8_t, 9>>& columnOrders() {
+        static const vector<array<uint8_t, 9>> orders = []() {
+            const uint8_t (*perms)[3] = permutations();
+            vector<array<uint8_t, 9>> result;
+            for (int s = 0; s < 6; s++) {
+                for (int a = 0; a < 6; a++) {
+                    for (int b = 0; b < 6; b++) {
+                        for (int c = 0; c < 6; c++) {
+                            const int within[3] = {a, b, c};
+                            array<uint8_t, 9> order;
+                            for (int slot = 0; slot < 3; slot++) {
+                                int stack = perms[s][slot];
+                                for (int k = 0; k < 3; k++) {
+                                    order[slot * 3 + k] = stack * 3 + perms[within[slot]][k];
+                                }
+                            }
+                            result.push_back(order);
+                        }
+                    }
+                }
+            }
+            return result;
+        }();
+        return orders;
+    }
+
+    static uint8_t cellAt(const uint8_t* board, int transpose, int row, int col) {
+        return transpose ? board[col * 9 + row] : board[row * 9 + col];
+    }
+
+    // Sort key of an output cell: labels in order, empty cells last
+    static int sortKey(uint8_t label) {
+        return label == 0 ? 10 : label;
+    }
+
+    // Rows that may be placed next in a state: any row of an unused band at
+    // the start of a band, otherwise the unused rows of the current band
+    static uint16_t nextRows(const State& state) {
+        if (state.placed % 3 == 0) {
+            uint16_t rows = 0;
+            for (int band = 0; band < 3; band++) {
+                uint16_t bandRows = 7u << (band * 3);
+                if ((state.usedRows & bandRows) == 0) rows |= bandRows;
+            }
+            return rows;
+        }
+        int band = state.rows[state.placed - 1] / 3;
+        return (7u << (band * 3)) & ~state.usedRows;
+    }
+
+public:
+    static void canonicalize(const uint8_t* board, CanonicalBoard& result) {
+        const vector<array<uint8_t, 9>>& orders = columnOrders();
+        vector<State> states, next;
+
+        // First row: relabeling starts afresh, so its labels are 1, 2, 3...
+        // in order and only the clue pattern matters. The best pattern puts
+        // the stacks in decreasing clue count with clues first in each stack.
+        // A row's best pattern is summed up by its sorted stack counts.
+        int profiles[2][9];
+        int bestProfile = -1;
+        for (int transpose = 0; transpose < 2; transpose++) {
+            for (int row = 0; row < 9; row++) {
+                int counts[3] = {0, 0, 0};
+                for (int col = 0; col < 9; col++) {
+                    if (cellAt(board, transpose, row, col) != 0) counts[col / 3]++;
+                }
+                sort(counts, counts + 3, greater<int>());
+                profiles[transpose][row] = counts[0] * 16 + counts[1] * 4 + counts[2];
+                bestProfile = max(bestProfile, profiles[transpose][row]);
+            }
+        }
+
+        for (int transpose = 0; transpose < 2; transpose++) {
+            for (int row = 0; row < 9; row++) {
+                if (profiles[transpose][row] != bestProfile) continue;
+
+                // Column orders giving the best pattern: stacks in decreasing
+                // clue count, clue columns ahead of empty ones in each stack
+                bool clue[9];
+                int counts[3] = {0, 0, 0};
+                for (int col = 0; col < 9; col++) {
+                    clue[col] = cellAt(board, transpose, row, col) != 0;
+                    counts[col / 3] += clue[col];
+                }
+                const uint8_t (*perms)[3] = permutations();
+                for (int s = 0; s < 6; s++) {
+                    if (counts[perms[s][0]] < counts[perms[s][1]] || counts[perms[s][1]] < counts[perms[s][2]]) continue;
+                    bool valid[3][6];
+                    for (int stack = 0; stack < 3; stack++) {
+                        for (int w = 0; w < 6; w++) {
+                            const bool* c = clue + stack * 3;
+                            valid[stack][w] = c[perms[w][0]] >= c[perms[w][1]] && c[perms[w][1]] >= c[perms[w][2]];
+                        }
+                    }
+                    for (int a = 0; a < 6; a++) {
+                        if (!valid[perms[s][0]][a]) continue;
+                        for (int b = 0; b < 6; b++) {
+                            if (!valid[perms[s][1]][b]) continue;
+                            for (int c = 0; c < 6; c++) {
+                                if (!valid[perms[s][2]][c]) continue;
+                                if (states.size() >= MAX_STATES) {
+                                    result.exact = false;
+                                    return;
+                                }
+                                int o = ((s * 6 + a) * 6 + b) * 6 + c;
+
+                                State state;
+                                memset(&state, 0, sizeof(state));
+                                state.columnOrder = o;
+                                state.transpose = transpose;
+                                state.placed = 1;
+                                state.usedRows = 1u << row;
+                                state.rows[0] = row;
+                                state.nextLabel = 1;
+                                for (int slot = 0; slot < 9; slot++) {
+                                    uint8_t digit = cellAt(board, transpose, row, orders[o][slot]);
+                                    if (digit != 0) state.digits[digit] = state.nextLabel++;
+                                }
+                                states.push_back(state);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Remaining rows: keep the placements that tie the smallest next row
+        for (int placed = 1; placed < 9; placed++) {
+            int best[9];
+            bool found = false, cut = false;
+            next.clear();
+            for (size_t s = 0; s < states.size(); s++) {
+                const State& state = states[s];
+                const array<uint8_t, 9>& cols = orders[state.columnOrder];
+                for (uint16_t rows = nextRows(state); rows != 0; rows &= rows - 1) {
+                    int row = __builtin_ctz(rows);
+                    State candidate = state;
+                    int keys[9];
+                    int order = found ? 0 : -1;
+                    for (int slot = 0; slot < 9; slot++) {
+                        uint8_t digit = cellAt(board, state.transpose, row, cols[slot]);
+                        uint8_t label = 0;
+                        if (digit != 0) {
+                            if (candidate.digits[digit] == 0) candidate.digits[digit] = candidate.nextLabel++;
+                            label = candidate.digits[digit];
+                        }
+                        keys[slot] = sortKey(label);
+                        if (order == 0) order = keys[slot] - best[slot];
+                        if (order > 0) break;
+                    }
+                    if (order > 0) continue;
+                    if (order < 0) {
+                        memcpy(best, keys, sizeof(keys));
+                        found = true;
+                        cut = false;
+                        next.clear();
+                    }
+                    if (next.size() >= MAX_STATES) {
+                        cut = true;
+                        continue;
+                    }
+                    candidate.rows[placed] = row;
+                    candidate.usedRows |= 1u << row;
+                    candidate.placed = placed + 1;
+                    next.push_back(candidate);
+                }
+            }
+            if (cut) {
+                result.exact = false;
+                return;
+            }
+            states.swap(next);
+        }
+
+        // Every survivor gives the same board; take the first
+        const State& winner = states.front();
+        BoardTransform& transform = result.transform;
+        transform.transpose = winner.transpose != 0;
+        memcpy(transform.rows, winner.rows, 9);
+        memcpy(transform.cols, orders[winner.columnOrder].data(), 9);
+        memcpy(transform.digits, winner.digits, 10);
+
+        // Digits missing from the board take the labels left over, in order
+        uint8_t label = winner.nextLabel;
+        for (int digit = 1; digit <= 9; digit++) {
+            if (transform.digits[digit] == 0) transform.digits[digit] = label++;
+        }
+        transform.digits[0] = 0;
+        transform.apply(board, result.cells);
+        result.exact = true;
+    }
+};
+
+// Canonical form of a 9x9 board (81 cells, 0 for empty); check `exact`
+inline void canonicalizeBoard(const uint8_t* board, CanonicalBoard& result) {
+    BoardCanonicalizer::canonicalize(board, result);
+}
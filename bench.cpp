@@ -0,0 +1,650 @@
+#include "SudokuSolver.cpp"
+#include "BatchSolver.cpp"
+#include "GridValidator.cpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+
+// Benchmark harness: runs every engine over the puzzle corpora in
+// benchmarks/ with warm-up and repeated passes, and reports latency
+// percentiles, puzzles/sec and search nodes/sec per engine and corpus.
+// Results can be written as JSON (one record per line, so two runs diff
+// cleanly) and compared against a saved baseline.
+
+struct BenchEngine {
+    string id;
+    string name;
+    size_t maxPuzzles;                       // 0 for the whole corpus
+    bool onRequest;                          // only run when named with --engine
+    int searchThreads;                       // threads one puzzle's search is split across
+    SearchHeuristics heuristics;             // value order, restarts and nogoods of the search
+};
+
+struct BenchCorpus {
+    string name;
+    string file;
+};
+
+struct BenchOptions {
+    string corpusDir = "benchmarks";
+    string jsonPath;                         // empty for no JSON output
+    string baselinePath;                     // earlier JSON to compare against
+    vector<string> engineIds;                // empty for every engine
+    int warmup = 1;                          // untimed passes per engine and corpus
+    int repeats = 5;                         // timed passes per engine and corpus
+    bool full = false;                       // run the slow engines on whole corpora
+    string portfolio = DEFAULT_PORTFOLIO;    // racers of the portfolio engine
+    int scalingThreads = 0;                  // split-search scaling run up to this many threads
+    bool calibrate = false;                  // fit the auto engine's thresholds instead
+};
+
+struct BenchResult {
+    string engine;
+    string corpus;
+    size_t puzzles = 0;
+    size_t solved = 0;
+    size_t samples = 0;
+    double minMs = 0;
+    double medianMs = 0;
+    double p99Ms = 0;
+    double puzzlesPerSec = 0;
+    double nodesPerSec = 0;
+    double nodesPerPuzzle = 0;
+};
+
+// The reference engines need up to a second on a 17-clue puzzle, so by
+// default they only run on the first puzzles of each corpus. The cut is
+// fixed, so two runs always measure the same puzzles. The portfolio race
+// runs a thread per racer, so it is only measured when asked for, as are
+// the constraint engine's search heuristics (compare their p99 against
+// plain constraint with --full).
+vector<BenchEngine> getBenchEngines() {
+    return {
+        {"backtracking", "Backtracking", 5, false, 1, {}},
+        {"constraint", "Constraint Propagation", 5, false, 1, {}},
+        {"constraint-lcv", "Constraint (least constraining)", 5, true, 1, {VALUE_ORDER_LEAST_CONSTRAINING}},
+        {"constraint-random", "Constraint (random order)", 5, true, 1, {VALUE_ORDER_RANDOM, 1}},
+        {"constraint-restarts", "Constraint (restarts, nogoods)", 5, true, 1,
+         {VALUE_ORDER_ASCENDING, 1, 200, 1.5, 1 << 16}},
+        {"bitmask", "Bitmask Propagation", 0, false, 1, {}},
+        {"dlx", "Dancing Links", 0, false, 1, {}},
+        {"auto", "Auto (routed per puzzle)", 0, false, 1, {}},
+        {"portfolio", "Portfolio Race", 0, true, 1, {}}
+    };
+}
+
+// The constraint engine with its search split across 1, 2, 4... threads,
+// up to maxThreads, on whole corpora
+vector<BenchEngine> getScalingEngines(int maxThreads) {
+    vector<BenchEngine> engines;
+    for (int threads = 1; ; threads = min(threads * 2, maxThreads)) {
+        engines.push_back({"constraint-t" + to_string(threads),
+                           "Constraint Propagation (" + to_string(threads) + " threads)", 0, false, threads, {}});
+        if (threads == maxThreads) break;
+    }
+    return engines;
+}
+
+vector<BenchCorpus> getBenchCorpora() {
+    return {
+        {"easy", "easy.txt"},
+        {"minimal17", "minimal17.txt"},
+        {"hard", "hard.txt"}
+    };
+}
+
+// Latency at quantile q of a sorted sample (nearest rank)
+double percentile(const vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)(q * sorted.size() + 0.999999);
+    if (rank < 1) rank = 1;
+    return sorted[min(rank, sorted.size()) - 1];
+}
+
+// Run one engine over one corpus
+BenchResult runBenchmark(const BenchEngine& engine, const BenchCorpus& corpus,
+                         const vector<Grid>& puzzles, const BenchOptions& options) {
+    // Scaling and heuristic runs tag the engine id after a dash
+    bool (SudokuSolver::*solve)() = solverEngine<3>(engine.id.substr(0, engine.id.find('-')));
+    size_t count = puzzles.size();
+    if (engine.maxPuzzles > 0 && !options.full) count = min(count, engine.maxPuzzles);
+
+    SudokuSolver solver;
+    solver.setSearchThreads(engine.searchThreads);
+    solver.setSearchHeuristics(engine.heuristics);
+    unique_ptr<PortfolioSolver<3>> portfolio;
+    if (engine.id == "portfolio") {
+        vector<PortfolioEntry> racers;
+        parsePortfolio(options.portfolio, racers);
+        portfolio.reset(new PortfolioSolver<3>(racers));
+    }
+
+    // Solve one puzzle, leaving the answer on `solver`
+    uint64_t nodes = 0;
+    auto run = [&](const Grid& puzzle) {
+        if (!portfolio) {
+            solver.setBoard(puzzle);
+            bool solved = (solver.*solve)();
+            nodes = solver.getNodeCount();
+            return solved;
+        }
+        PortfolioSolver<3>::Result race = portfolio->solve(puzzle);
+        solver.setBoard(race.solution);
+        nodes = race.totalNodes;
+        return race.status == SOLVE_SOLVED;
+    };
+
+    for (int pass = 0; pass < options.warmup; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            run(puzzles[i]);
+        }
+    }
+
+    BenchResult result;
+    result.engine = engine.id;
+    result.corpus = corpus.name;
+    result.puzzles = count;
+
+    vector<double> latencies;
+    latencies.reserve(count * options.repeats);
+    double totalSeconds = 0;
+    uint64_t totalNodes = 0;
+
+    for (int pass = 0; pass < options.repeats; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            auto start = chrono::steady_clock::now();
+            bool solved = run(puzzles[i]);
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+            latencies.push_back(elapsed.count() * 1000.0);
+            totalSeconds += elapsed.count();
+            totalNodes += nodes;
+            if (pass == 0 && solved && solver.isComplete() && solver.isValidBoard()) {
+                result.solved++;
+            }
+        }
+    }
+
+    sort(latencies.begin(), latencies.end());
+    result.samples = latencies.size();
+    if (!latencies.empty()) {
+        result.minMs = latencies.front();
+        result.medianMs = percentile(latencies, 0.5);
+        result.p99Ms = percentile(latencies, 0.99);
+        result.nodesPerPuzzle = (double)totalNodes / latencies.size();
+    }
+    if (totalSeconds > 0) {
+        result.puzzlesPerSec = latencies.size() / totalSeconds;
+        result.nodesPerSec = totalNodes / totalSeconds;
+    }
+    return result;
+}
+
+// Time one bulk validation kernel over a set of grids, repeated up to at
+// least VALIDATE_GRIDS per pass and checked in batches of VALIDATE_BATCH.
+// Latencies are per batch; puzzles/sec is grids/sec, and "solved" counts
+// grids found valid and complete.
+const size_t VALIDATE_GRIDS = 1 << 18;
+const size_t VALIDATE_BATCH = 4096;
+
+BenchResult runValidation(const GridValidator<3>& validator, const string& corpusName,
+                          const vector<Grid>& grids, const BenchOptions& options) {
+    vector<Grid> stream;
+    while (!grids.empty() && stream.size() < VALIDATE_GRIDS) {
+        stream.insert(stream.end(), grids.begin(), grids.end());
+    }
+    vector<GridCheck> checks(stream.size());
+
+    for (int pass = 0; pass < options.warmup; pass++) {
+        validator.validate(stream.data(), stream.size(), checks.data());
+    }
+
+    BenchResult result;
+    result.engine = string("validate-") + validator.name;
+    result.corpus = corpusName;
+    result.puzzles = grids.size();
+
+    vector<double> latencies;
+    double totalSeconds = 0;
+    for (int pass = 0; pass < options.repeats; pass++) {
+        for (size_t start = 0; start < stream.size(); start += VALIDATE_BATCH) {
+            size_t count = min(VALIDATE_BATCH, stream.size() - start);
+            auto begin = chrono::steady_clock::now();
+            validator.validate(stream.data() + start, count, checks.data() + start);
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+            latencies.push_back(elapsed.count() * 1000.0);
+            totalSeconds += elapsed.count();
+        }
+    }
+    for (size_t i = 0; i < grids.size(); i++) {
+        if (checks[i].valid && checks[i].complete) result.solved++;
+    }
+
+    sort(latencies.begin(), latencies.end());
+    result.samples = latencies.size();
+    if (!latencies.empty()) {
+        result.minMs = latencies.front();
+        result.medianMs = percentile(latencies, 0.5);
+        result.p99Ms = percentile(latencies, 0.99);
+    }
+    if (totalSeconds > 0) {
+        result.puzzlesPerSec = stream.size() * options.repeats / totalSeconds;
+    }
+    return result;
+}
+
+// Grids for every verdict of the validation kernels: the solutions and the
+// puzzles as they are, then each solution with a digit repeated in a row,
+// with an empty cell and with an out-of-range byte, and an empty grid. The
+// count leaves the vector kernels a scalar tail as well.
+vector<Grid> validationCases(const vector<Grid>& solutions, const vector<Grid>& givens) {
+    vector<Grid> cases(solutions);
+    cases.insert(cases.end(), givens.begin(), givens.end());
+    for (size_t k = 0; k < solutions.size(); k++) {
+        int cell = (int)(k * 7 % 81);
+        Grid repeated = solutions[k];
+        repeated[cell] = repeated[cell / 9 * 9 + (cell % 9 + 1) % 9];
+        cases.push_back(repeated);
+        Grid emptied = solutions[k];
+        emptied[k * 13 % 81] = 0;
+        cases.push_back(emptied);
+        Grid corrupt = solutions[k];
+        corrupt[k * 11 % 81] = (uint8_t)(10 + k % 246);
+        cases.push_back(corrupt);
+    }
+    cases.push_back(Grid());
+    if (cases.size() % 2 == 0) cases.pop_back();
+    return cases;
+}
+
+// Every kernel must give the scalar kernel's verdict on every case;
+// reports the first grid each other kernel gets wrong
+bool validatorsAgree(const vector<GridValidator<3>>& validators, const vector<Grid>& cases) {
+    vector<GridCheck> expected(cases.size()), checks(cases.size());
+    validators[0].validate(cases.data(), cases.size(), expected.data());
+    bool agree = true;
+    for (size_t v = 1; v < validators.size(); v++) {
+        validators[v].validate(cases.data(), cases.size(), checks.data());
+        for (size_t i = 0; i < cases.size(); i++) {
+            if (checks[i].valid != expected[i].valid || checks[i].complete != expected[i].complete ||
+                checks[i].conflictUnit != expected[i].conflictUnit) {
+                cerr << "Validation kernel " << validators[v].name << " disagrees with "
+                     << validators[0].name << " on grid " << formatPuzzleLine(cases[i]) << "\n";
+                agree = false;
+                break;
+            }
+        }
+    }
+    return agree;
+}
+
+// Node budget of one calibration solve; backtracking on a 17-clue puzzle
+// can take seconds, and a route that needs more never wins anyway
+const uint64_t CALIBRATE_MAX_NODES = 1000000;
+
+// Time every route of the auto engine on every puzzle of the corpora (best
+// of the timed passes, on the board left after the singles), fit the
+// thresholds to the samples, and compare the total time of each engine
+// alone, the current routing, the fitted one and a perfect router
+void runCalibration(const vector<BenchCorpus>& corpora, const vector<vector<Grid>>& puzzles,
+                    const BenchOptions& options) {
+    const SolveRoute routes[] = {ROUTE_BACKTRACKING, ROUTE_BITMASK, ROUTE_DLX};
+    vector<RoutingSample> samples;
+    SudokuSolver solver;
+    for (size_t c = 0; c < corpora.size(); c++) {
+        cout << "  Timing every route on " << corpora[c].name << "...\n" << flush;
+        for (size_t i = 0; i < puzzles[c].size(); i++) {
+            RoutingSample sample;
+            solver.setBoard(puzzles[c][i]);
+            sample.features = solver.propagateSingles();
+            Grid reduced = solver.getGrid();
+            for (SolveRoute route : routes) {
+                bool (SudokuSolver::*solve)() = solverEngine<3>(SOLVE_ROUTE_NAMES[route]);
+                double best = numeric_limits<double>::infinity();
+                for (int pass = 0; pass < options.warmup + options.repeats; pass++) {
+                    solver.setBoard(reduced);
+                    SolveLimits limits;
+                    limits.maxNodes = CALIBRATE_MAX_NODES;
+                    auto start = chrono::steady_clock::now();
+                    SolveStatus status = solver.solveWithLimits(solve, limits);
+                    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+                    if (status == SOLVE_TIMED_OUT) break;
+                    if (pass >= options.warmup) best = min(best, elapsed.count());
+                }
+                sample.seconds[route] = best;
+            }
+            samples.push_back(sample);
+        }
+    }
+
+    SudokuSolver defaults;
+    AutoRouting current = defaults.getAutoRouting();
+    AutoRouting fitted = calibrateAutoRouting(samples);
+    double oracle = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (current.route(samples[i].features) == ROUTE_SINGLES) continue;
+        oracle += min(samples[i].seconds[ROUTE_BACKTRACKING],
+                      min(samples[i].seconds[ROUTE_BITMASK], samples[i].seconds[ROUTE_DLX]));
+    }
+
+    // A route over the node budget on some puzzle has no total
+    auto printTotal = [](const string& label, double seconds) {
+        cout << left << setw(34) << label << right << fixed << setprecision(3) << setw(14);
+        if (seconds == numeric_limits<double>::infinity()) {
+            cout << "over budget" << "\n";
+        } else {
+            cout << seconds * 1000.0 << "\n";
+        }
+    };
+
+    cout << "\nAUTO ENGINE CALIBRATION (" << samples.size() << " puzzles, total ms)\n";
+    cout << string(50, '-') << "\n";
+    for (SolveRoute route : routes) {
+        AutoRouting only;
+        only.trivialOpen = route == ROUTE_BACKTRACKING ? 1 : 0;
+        only.dlxBranching = route == ROUTE_DLX ? 2 : 0;
+        printTotal(string(SOLVE_ROUTE_NAMES[route]) + " alone", routedSeconds(samples, only));
+    }
+    printTotal("auto, current thresholds", routedSeconds(samples, current));
+    printTotal("auto, fitted thresholds", routedSeconds(samples, fitted));
+    printTotal("best route per puzzle", oracle);
+    cout << "\nCurrent thresholds: " << setprecision(3) << current.trivialOpen << "," << current.dlxBranching << "\n";
+    cout << "Fitted thresholds:  " << fitted.trivialOpen << "," << fitted.dlxBranching
+         << "  (sudoku_solver --batch ... --auto-thresholds " << fitted.trivialOpen << ","
+         << fitted.dlxBranching << ")\n";
+}
+
+// One JSON record per line
+void writeJson(const vector<BenchResult>& results, const BenchOptions& options,
+               const char* kernelName, ostream& out) {
+    out << "{\n";
+    out << "  \"kernel\": \"" << kernelName << "\",\n";
+    out << "  \"warmup\": " << options.warmup << ",\n";
+    out << "  \"repeats\": " << options.repeats << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"engine\": \"" << r.engine << "\", \"corpus\": \"" << r.corpus << "\""
+            << ", \"puzzles\": " << r.puzzles << ", \"solved\": " << r.solved
+            << ", \"samples\": " << r.samples << fixed << setprecision(4)
+            << ", \"min_ms\": " << r.minMs << ", \"median_ms\": " << r.medianMs
+            << ", \"p99_ms\": " << r.p99Ms << setprecision(1)
+            << ", \"puzzles_per_sec\": " << r.puzzlesPerSec
+            << ", \"nodes_per_sec\": " << r.nodesPerSec
+            << ", \"nodes_per_puzzle\": " << r.nodesPerPuzzle << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Value of "key" in one result line written by writeJson
+string jsonField(const string& line, const string& key) {
+    string tag = "\"" + key + "\": ";
+    size_t start = line.find(tag);
+    if (start == string::npos) return "";
+    start += tag.size();
+    if (line[start] == '"') {
+        size_t end = line.find('"', start + 1);
+        return line.substr(start + 1, end - start - 1);
+    }
+    size_t end = line.find_first_of(",}", start);
+    return line.substr(start, end - start);
+}
+
+// Load the results of an earlier run
+bool readBaseline(const string& path, vector<BenchResult>& results) {
+    ifstream input(path.c_str());
+    if (!input) {
+        cerr << "Cannot open baseline file: " << path << "\n";
+        return false;
+    }
+    string line;
+    while (getline(input, line)) {
+        if (line.find("\"engine\"") == string::npos) continue;
+        BenchResult r;
+        r.engine = jsonField(line, "engine");
+        r.corpus = jsonField(line, "corpus");
+        r.puzzles = atol(jsonField(line, "puzzles").c_str());
+        r.medianMs = atof(jsonField(line, "median_ms").c_str());
+        r.p99Ms = atof(jsonField(line, "p99_ms").c_str());
+        r.puzzlesPerSec = atof(jsonField(line, "puzzles_per_sec").c_str());
+        r.nodesPerPuzzle = atof(jsonField(line, "nodes_per_puzzle").c_str());
+        results.push_back(r);
+    }
+    return true;
+}
+
+// Print the results table
+void printResults(const vector<BenchResult>& results) {
+    cout << "\n" << left << setw(20) << "Engine" << setw(11) << "Corpus" << right
+         << setw(8) << "Solved" << setw(11) << "Min ms" << setw(11) << "Median ms"
+         << setw(11) << "p99 ms" << setw(13) << "Puzzles/s" << setw(14) << "Nodes/s" << "\n";
+    cout << string(99, '-') << "\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        ostringstream solved;
+        solved << r.solved << "/" << r.puzzles;
+        cout << left << setw(20) << r.engine << setw(11) << r.corpus << right
+             << setw(8) << solved.str() << fixed << setprecision(3)
+             << setw(11) << r.minMs << setw(11) << r.medianMs << setw(11) << r.p99Ms
+             << setprecision(0) << setw(13) << r.puzzlesPerSec << setw(14) << r.nodesPerSec << "\n";
+    }
+}
+
+// Print the split-search speedup per corpus: total time and median latency
+// against one thread, with a bar per thread count
+void printScaling(const vector<BenchResult>& results, const vector<BenchEngine>& engines,
+                  const vector<BenchCorpus>& corpora) {
+    for (size_t c = 0; c < corpora.size(); c++) {
+        cout << "\nSCALING: constraint search split across threads, " << corpora[c].name << " corpus\n";
+        cout << left << setw(9) << "Threads" << right << setw(11) << "Median ms" << setw(11) << "p99 ms"
+             << setw(10) << "Speedup" << "\n";
+        cout << string(82, '-') << "\n";
+        const BenchResult* single = nullptr;
+        for (size_t e = 0; e < engines.size(); e++) {
+            const BenchResult* r = nullptr;
+            for (size_t i = 0; i < results.size(); i++) {
+                if (results[i].engine == engines[e].id && results[i].corpus == corpora[c].name) r = &results[i];
+            }
+            if (!r) continue;
+            if (!single) single = r;
+            double speedup = single->puzzlesPerSec > 0 ? r->puzzlesPerSec / single->puzzlesPerSec : 0;
+            int bar = (int)(speedup * 40 / max(1, engines.back().searchThreads) + 0.5);
+            cout << left << setw(9) << engines[e].searchThreads << right << fixed << setprecision(3)
+                 << setw(11) << r->medianMs << setw(11) << r->p99Ms << setprecision(2)
+                 << setw(9) << speedup << "x  " << string(bar, '#') << "\n";
+        }
+    }
+    cout << "(bars: speedup in total corpus time, full width = linear scaling)\n";
+}
+
+// Print the change against a baseline run, engine by engine
+void printComparison(const vector<BenchResult>& results, const vector<BenchResult>& baseline) {
+    cout << "\nCHANGE AGAINST BASELINE (median latency, throughput, nodes per puzzle)\n";
+    cout << string(73, '-') << "\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        const BenchResult* old = nullptr;
+        for (size_t j = 0; j < baseline.size(); j++) {
+            if (baseline[j].engine == r.engine && baseline[j].corpus == r.corpus) old = &baseline[j];
+        }
+        cout << left << setw(20) << r.engine << setw(11) << r.corpus << right;
+        if (!old || old->puzzles != r.puzzles || old->medianMs <= 0 || old->puzzlesPerSec <= 0) {
+            cout << "  (no comparable baseline)\n";
+            continue;
+        }
+        cout << fixed << setprecision(1) << showpos
+             << setw(9) << (r.medianMs / old->medianMs - 1) * 100 << "%"
+             << setw(9) << (r.puzzlesPerSec / old->puzzlesPerSec - 1) * 100 << "%";
+        if (old->nodesPerPuzzle > 0) {
+            cout << setw(9) << (r.nodesPerPuzzle / old->nodesPerPuzzle - 1) * 100 << "%";
+        }
+        cout << noshowpos << "\n";
+    }
+}
+
+void printBenchUsage(const char* program) {
+    cout << "Usage: " << program << " [options]\n";
+    cout << "  --corpus-dir <dir>   Directory holding easy.txt, minimal17.txt, hard.txt (default: benchmarks)\n";
+    cout << "  --engine <id>        Only this engine (repeatable): backtracking, constraint, bitmask, dlx,\n";
+    cout << "                       auto, or portfolio, constraint-lcv, constraint-random and\n";
+    cout << "                       constraint-restarts (not run by default), or validate for the\n";
+    cout << "                       bulk grid validation kernels alone\n";
+    cout << "  --portfolio <list>   Racers of the portfolio engine (default: " << DEFAULT_PORTFOLIO << ")\n";
+    cout << "  --warmup <n>         Untimed passes per engine and corpus (default: 1)\n";
+    cout << "  --repeats <n>        Timed passes per engine and corpus (default: 5)\n";
+    cout << "  --full               Run the reference engines on whole corpora\n";
+    cout << "  --scaling <n>        Instead, time the constraint search split across 1, 2, 4... n\n";
+    cout << "                       threads on the 17-clue and hard corpora and chart the speedup\n";
+    cout << "  --calibrate          Instead, time every route of the auto engine on every puzzle\n";
+    cout << "                       and fit its thresholds to the corpora\n";
+    cout << "  --json <file>        Write the results as JSON\n";
+    cout << "  --compare <file>     Compare against the JSON of an earlier run\n";
+}
+
+bool parseBenchOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--full") {
+            options.full = true;
+            continue;
+        }
+        if (arg == "--calibrate") {
+            options.calibrate = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (arg == "--corpus-dir") {
+            options.corpusDir = value;
+        } else if (arg == "--engine") {
+            options.engineIds.push_back(value);
+        } else if (arg == "--portfolio") {
+            vector<PortfolioEntry> racers;
+            if (!parsePortfolio(value, racers)) return false;
+            options.portfolio = value;
+        } else if (arg == "--scaling") {
+            options.scalingThreads = atoi(value.c_str());
+            if (options.scalingThreads < 1) return false;
+        } else if (arg == "--warmup") {
+            options.warmup = max(0, atoi(value.c_str()));
+        } else if (arg == "--repeats") {
+            options.repeats = max(1, atoi(value.c_str()));
+        } else if (arg == "--json") {
+            options.jsonPath = value;
+        } else if (arg == "--compare") {
+            options.baselinePath = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseBenchOptions(argc, argv, options)) {
+        printBenchUsage(argv[0]);
+        return 1;
+    }
+
+    vector<BenchResult> baseline;
+    if (!options.baselinePath.empty() && !readBaseline(options.baselinePath, baseline)) {
+        return 1;
+    }
+
+    SudokuSolver probe;
+    cout << "Sudoku benchmark: " << options.warmup << " warm-up and " << options.repeats
+         << " timed passes, " << probe.propagationKernelName() << " propagation kernel\n";
+
+    vector<BenchCorpus> corpora = getBenchCorpora();
+    vector<vector<Grid>> puzzles(corpora.size());
+    for (size_t c = 0; c < corpora.size(); c++) {
+        PuzzleCorpus corpus;
+        if (!corpus.openFile(options.corpusDir + "/" + corpora[c].file)) {
+            return 1;
+        }
+        for (size_t i = 0; i < corpus.size(); i++) {
+            Grid grid;
+            if (corpus.puzzle<3>(i, grid)) {
+                puzzles[c].push_back(grid);
+            }
+        }
+    }
+
+    if (options.calibrate) {
+        runCalibration(corpora, puzzles, options);
+        return 0;
+    }
+
+    vector<BenchResult> results;
+    bool scaling = options.scalingThreads > 0;
+    vector<BenchEngine> engines = scaling ? getScalingEngines(options.scalingThreads) : getBenchEngines();
+    for (size_t e = 0; e < engines.size(); e++) {
+        bool named = find(options.engineIds.begin(), options.engineIds.end(), engines[e].id) != options.engineIds.end();
+        if (!scaling && !named && (!options.engineIds.empty() || engines[e].onRequest)) {
+            continue;
+        }
+        for (size_t c = 0; c < corpora.size(); c++) {
+            if (scaling && corpora[c].name == "easy") continue;
+            cout << "  " << engines[e].name << " on " << corpora[c].name << "...\n" << flush;
+            results.push_back(runBenchmark(engines[e], corpora[c], puzzles[c], options));
+        }
+    }
+
+    // Bulk validation of the corpora's solutions and of their givens
+    bool validate = find(options.engineIds.begin(), options.engineIds.end(), "validate") != options.engineIds.end();
+    if (!scaling && (options.engineIds.empty() || validate)) {
+        vector<Grid> givens, solutions;
+        SudokuSolver solver;
+        for (size_t c = 0; c < corpora.size(); c++) {
+            for (size_t i = 0; i < puzzles[c].size(); i++) {
+                givens.push_back(puzzles[c][i]);
+                solver.setBoard(puzzles[c][i]);
+                if (solver.solveBitmask()) solutions.push_back(solver.getGrid());
+            }
+        }
+        vector<GridValidator<3>> validators = availableGridValidators<3>();
+        vector<Grid> cases = validationCases(solutions, givens);
+        if (!validatorsAgree(validators, cases)) return 1;
+        cout << "  Bulk validation kernels agree on " << cases.size() << " grids\n";
+        for (size_t v = 0; v < validators.size(); v++) {
+            cout << "  Bulk validation (" << validators[v].name << ")...\n" << flush;
+            results.push_back(runValidation(validators[v], "solutions", solutions, options));
+            results.push_back(runValidation(validators[v], "givens", givens, options));
+        }
+    }
+
+    printResults(results);
+    if (scaling) {
+        vector<BenchCorpus> scaled;
+        for (size_t c = 0; c < corpora.size(); c++) {
+            if (corpora[c].name != "easy") scaled.push_back(corpora[c]);
+        }
+        printScaling(results, engines, scaled);
+    }
+    if (!baseline.empty()) {
+        printComparison(results, baseline);
+    }
+
+    if (!options.jsonPath.empty()) {
+        ofstream json(options.jsonPath.c_str());
+        if (!json) {
+            cerr << "Cannot open JSON file: " << options.jsonPath << "\n";
+            return 1;
+        }
+        writeJson(results, options, probe.propagationKernelName(), json);
+        cout << "\nResults written to " << options.jsonPath << "\n";
+    }
+
+    return 0;
+}
@@ -1,8 +1,13 @@
 #include "SudokuSolver.cpp"
+#include "BatchSolver.cpp"
+#include "ShardedRun.cpp"
+#include "SolveServer.cpp"
+#include "PuzzleGenerator.cpp"
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <string>
+#include <cstdlib>
 
 using namespace std;
 
@@ -80,59 +85,101 @@ vector<vector<int>> inputBoard() {
     return board;
 }
 
+// Solving engines available for comparison and manual solving
+struct SolverEngine {
+    string id;
+    string name;
+    bool (SudokuSolver::*solve)();
+};
+
+vector<SolverEngine> getEngines() {
+    return {
+        {"backtracking", "Backtracking", &SudokuSolver::solveBacktracking},
+        {"constraint", "Constraint Propagation", &SudokuSolver::solveConstraintPropagation},
+        {"bitmask", "Bitmask Propagation", &SudokuSolver::solveBitmask},
+        {"dlx", "Dancing Links", &SudokuSolver::solveDancingLinks},
+        {"auto", "Auto", &SudokuSolver::solveAuto}
+    };
+}
+
 // Function to compare algorithms
 void compareAlgorithms(const vector<vector<int>>& puzzle, const string& puzzleName) {
     cout << "\n" << string(60, '=') << "\n";
     cout << "ALGORITHM COMPARISON: " << puzzleName << "\n";
     cout << string(60, '=') << "\n";
     
-    // Test Backtracking
-    SudokuSolver solver1;
-    solver1.setBoard(puzzle);
-    
-    cout << "\nOriginal Puzzle:";
-    solver1.printBoard();
-    
-    double backtrackingTime = measureTime([&]() {
-        solver1.solveBacktracking();
-    });
-    
-    cout << "\nBacktracking Solution:";
-    solver1.printBoard();
-    cout << "Backtracking Time: " << fixed << setprecision(3) << backtrackingTime << " ms\n";
-    
-    // Test Constraint Propagation
-    SudokuSolver solver2;
-    solver2.setBoard(puzzle);
-    
-    double constraintTime = measureTime([&]() {
-        solver2.solveConstraintPropagation();
-    });
+    vector<SolverEngine> engines = getEngines();
+    vector<double> times;
+    vector<vector<vector<int>>> solutions;
     
-    cout << "\nConstraint Propagation Solution:";
-    solver2.printBoard();
-    cout << "Constraint Propagation Time: " << fixed << setprecision(3) << constraintTime << " ms\n";
+    for (size_t i = 0; i < engines.size(); i++) {
+        SudokuSolver solver;
+        solver.setBoard(puzzle);
+        
+        if (i == 0) {
+            cout << "\nOriginal Puzzle:";
+            solver.printBoard();
+        }
+        
+        double time = measureTime([&]() {
+            (solver.*engines[i].solve)();
+        });
+        
+        cout << "\n" << engines[i].name << " Solution:";
+        solver.printBoard();
+        cout << engines[i].name << " Time: " << fixed << setprecision(3) << time << " ms\n";
+        if (engines[i].id == "auto" && solver.getLastRoute() == ROUTE_CACHE) {
+            cout << "Auto: answered from the solution cache\n";
+        } else if (engines[i].id == "auto") {
+            const PuzzleFeatures& features = solver.getPuzzleFeatures();
+            cout << "Auto: " << features.clues << " clues, " << features.singles << " singles, "
+                 << features.open << " cells left open -> " << SOLVE_ROUTE_NAMES[solver.getLastRoute()] << "\n";
+        }
+        if (SEARCH_STATS_ENABLED) {
+            cout << engines[i].name << " Search: " << solver.getSearchStats().toJson() << "\n";
+        }
+        
+        times.push_back(time);
+        solutions.push_back(solver.getBoard());
+    }
     
     // Performance comparison
     cout << "\n" << string(40, '-') << "\n";
     cout << "PERFORMANCE COMPARISON:\n";
     cout << string(40, '-') << "\n";
-    cout << "Backtracking:           " << setw(10) << backtrackingTime << " ms\n";
-    cout << "Constraint Propagation: " << setw(10) << constraintTime << " ms\n";
     
-    if (constraintTime < backtrackingTime) {
-        double speedup = backtrackingTime / constraintTime;
-        cout << "Constraint Propagation is " << fixed << setprecision(2) << speedup << "x faster!\n";
-    } else if (backtrackingTime < constraintTime) {
-        double speedup = constraintTime / backtrackingTime;
-        cout << "Backtracking is " << fixed << setprecision(2) << speedup << "x faster!\n";
-    } else {
-        cout << "Both algorithms performed similarly.\n";
+    size_t fastest = 0;
+    for (size_t i = 0; i < engines.size(); i++) {
+        cout << left << setw(24) << (engines[i].name + ":") << right
+             << setw(10) << times[i] << " ms\n";
+        if (times[i] < times[fastest]) fastest = i;
+    }
+    
+    cout << engines[fastest].name << " is fastest:\n";
+    for (size_t i = 0; i < engines.size(); i++) {
+        if (i == fastest || times[fastest] <= 0) continue;
+        double speedup = times[i] / times[fastest];
+        cout << "  " << fixed << setprecision(2) << speedup << "x faster than " << engines[i].name << "\n";
     }
     
     // Verify solutions are identical
-    bool solutionsMatch = (solver1.getBoard() == solver2.getBoard());
+    bool solutionsMatch = true;
+    for (size_t i = 1; i < solutions.size(); i++) {
+        if (solutions[i] != solutions[0]) solutionsMatch = false;
+    }
     cout << "Solutions match: " << (solutionsMatch ? "YES" : "NO") << "\n";
+
+    // Race the engines against each other, first answer wins
+    vector<PortfolioEntry> racers;
+    parsePortfolio(DEFAULT_PORTFOLIO, racers);
+    PortfolioSolver<3> portfolio(racers);
+    SudokuSolver input;
+    input.setBoard(puzzle);
+    PortfolioSolver<3>::Result race = portfolio.solve(input.getGrid());
+    if (race.winner >= 0) {
+        cout << "Portfolio race (" << DEFAULT_PORTFOLIO << "): " << racers[race.winner].label()
+             << " answered first in " << fixed << setprecision(3) << race.milliseconds << " ms\n";
+    }
 }
 
 // Function to demonstrate DSA concepts
@@ -168,7 +215,319 @@ void demonstrateDSAConcepts() {
     cout << "   - Efficient validation using sets\n";
 }
 
-int main() {
+// Command-line usage for the non-interactive modes
+void printUsage(const char* program) {
+    cout << "Usage:\n";
+    cout << "  " << program << "                       Interactive menu\n";
+    cout << "  " << program << " --batch <puzzles.txt> [options]\n";
+    cout << "  " << program << " --sharded <puzzles> --workdir <dir> [options]\n";
+    cout << "                       Batch run in checkpointed shards across worker processes;\n";
+    cout << "                       run it again after a kill to resume\n";
+    cout << "  " << program << " --serve [options]     HTTP solve service and web front end\n";
+    cout << "  " << program << " --generate <count> [options]\n";
+    cout << "  " << program << " --convert <in> <out> [--size <9|16|25>]\n";
+    cout << "                       Convert a puzzle file between text and the packed binary format\n";
+    cout << "\nBatch options:\n";
+    cout << "  --output <file>      Write solutions here instead of standard output\n";
+    cout << "  --threads <n>        Worker threads (default: all cores)\n";
+    cout << "  --engine <name>      backtracking, constraint, bitmask, dlx or auto (default: auto,\n";
+    cout << "                       which picks one of them per puzzle from cheap features)\n";
+    cout << "  --auto-thresholds <open,branching>\n";
+    cout << "                       Auto routing thresholds on 9x9 (default: 0.599,0.496; sudoku_bench\n";
+    cout << "                       --calibrate fits them to a corpus)\n";
+    cout << "  --portfolio <list>   Race these engines on each puzzle and keep the first answer:\n";
+    cout << "                       comma-separated engine[:seed], a seed solving under a random\n";
+    cout << "                       symmetry (e.g. " << DEFAULT_PORTFOLIO << ")\n";
+    cout << "  --search-threads <n> Split each puzzle's constraint search across n threads\n";
+    cout << "  --value-order <name> Digit order of the backtracking and constraint engines:\n";
+    cout << "                       ascending (default), lcv (least constraining) or random\n";
+    cout << "  --seed <n>           Seed of the random orders (default: 0)\n";
+    cout << "  --restarts <n>       Restart the search after n nodes, growing the budget each\n";
+    cout << "                       time and breaking ties at random (backtracking, constraint)\n";
+    cout << "  --restart-growth <f> Budget factor from one restart to the next (default: 1.5)\n";
+    cout << "  --nogoods <n>        Remember up to n dead-end boards per worker and skip them\n";
+    cout << "  --unique             Reject puzzles without exactly one solution\n";
+    cout << "  --stats <file>       Write per-puzzle search counters as JSON lines\n";
+    cout << "                       (node counts only unless built with make stats)\n";
+    cout << "  --size <9|16|25>     Grid size (default: 9)\n";
+    cout << "  --cache <n>          Reuse solutions of symmetric copies, keeping up to n (9x9 only)\n";
+    cout << "  --timeout <ms>       Give up on a puzzle after this long and report 'timeout'\n";
+    cout << "  --max-nodes <n>      Give up on a puzzle after n search nodes and report 'timeout'\n";
+    cout << "  --rules <list>       Inference rules for the bitmask engine and --unique:\n";
+    cout << "                       all (default), none, or a comma-separated list of\n";
+    cout << "                       hidden-singles, naked-pairs, hidden-pairs, pointing, box-line\n";
+    cout << "\nSharded options (plus the batch options but --threads, --portfolio and --stats):\n";
+    cout << "  --workdir <dir>      Checkpoints of the run, created if missing\n";
+    cout << "  --workers <n>        Worker processes, one thread each (default: all cores)\n";
+    cout << "  --shard-size <n>     Puzzles per shard (default: 10000)\n";
+    cout << "\nGenerate options:\n";
+    cout << "  --output <file>      Write puzzles here instead of standard output\n";
+    cout << "  --threads <n>        Worker threads (default: all cores)\n";
+    cout << "  --seed <n>           Random seed (default: 1)\n";
+    cout << "  --clues <n>          Stop removing clues at n (default: remove down to a minimal puzzle)\n";
+    cout << "  --difficulty <band>  any (default), easy, medium or hard\n";
+    cout << "\nServe options:\n";
+    cout << "  --port <n>           Port to listen on (default: 8000)\n";
+    cout << "  --host <address>     Address to bind (default: 127.0.0.1)\n";
+    cout << "  --threads <n>        Worker threads (default: all cores)\n";
+    cout << "  --queue <n>          Requests waiting for a worker before answering 503 (default: 64)\n";
+    cout << "  --root <dir>         Directory of index.html, styles.css and script.js (default: .)\n";
+    cout << "  --cache <n>          Solved puzzles kept for symmetric repeats (default: 10000, 0 for none)\n";
+    cout << "  --timeout <ms>       Per-puzzle solve deadline (default: 2000, 0 for none)\n";
+    cout << "  --batch-timeout <ms> Deadline of a whole /api/batch request (default: 10000, 0 for none)\n";
+    cout << "  --max-boards <n>     Play boards kept for /api/board, oldest dropped (default: 1000)\n";
+    cout << "\nInput: one puzzle per line, 81 characters (256 or 625 on the larger grids),\n";
+    cout << "digits 1-9 then letters A-P, '0' or '.' for empty cells.\n";
+    cout << "Output: one line per puzzle in input order: the solution, 'invalid', 'unsolvable'\n";
+    cout << "or (with --unique) 'multiple', or (with --timeout / --max-nodes) 'timeout'.\n";
+    cout << "Binary input (from --convert) is solved into a binary file of solutions, which\n";
+    cout << "needs --output; puzzles without a solution get an empty record.\n";
+}
+
+// Parse batch-mode arguments; returns false on a usage error
+bool parseBatchOptions(int argc, char* argv[], BatchOptions& options) {
+    if (argc < 3) return false;
+    options.inputPath = argv[2];
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--unique") {
+            options.requireUnique = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (arg == "--output") {
+            options.outputPath = value;
+        } else if (arg == "--stats") {
+            options.statsPath = value;
+        } else if (arg == "--threads") {
+            options.threads = atoi(value.c_str());
+        } else if (arg == "--size") {
+            int size = atoi(value.c_str());
+            if (size != 9 && size != 16 && size != 25) return false;
+            options.boxSize = size == 9 ? 3 : size == 16 ? 4 : 5;
+        } else if (arg == "--cache") {
+            options.cacheSize = atoi(value.c_str());
+        } else if (arg == "--search-threads") {
+            options.searchThreads = max(1, atoi(value.c_str()));
+        } else if (arg == "--timeout") {
+            options.timeoutMs = atof(value.c_str());
+        } else if (arg == "--max-nodes") {
+            options.maxNodes = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--auto-thresholds") {
+            if (!parseAutoRouting(value, options.routing)) {
+                cerr << "Bad auto thresholds: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--value-order") {
+            if (!parseValueOrder(value, options.heuristics.valueOrder)) {
+                cerr << "Unknown value order: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--seed") {
+            options.heuristics.seed = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--restarts") {
+            options.heuristics.restartNodes = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--restart-growth") {
+            options.heuristics.restartGrowth = atof(value.c_str());
+            if (!(options.heuristics.restartGrowth > 1)) {
+                cerr << "Restart growth must be above 1\n";
+                return false;
+            }
+        } else if (arg == "--nogoods") {
+            options.heuristics.nogoods = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--rules") {
+            if (!parseInferenceRules(value, options.inferenceRules)) {
+                cerr << "Unknown inference rule in: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--engine") {
+            bool found = false;
+            vector<SolverEngine> engines = getEngines();
+            for (size_t e = 0; e < engines.size(); e++) {
+                if (engines[e].id == value) {
+                    options.engineId = engines[e].id;
+                    options.engineName = engines[e].name;
+                    found = true;
+                }
+            }
+            if (!found) {
+                cerr << "Unknown engine: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--portfolio") {
+            if (!parsePortfolio(value, options.portfolio)) {
+                cerr << "Bad portfolio: " << value << "\n";
+                return false;
+            }
+            options.engineName = "Portfolio " + value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parse generate-mode arguments; returns false on a usage error
+bool parseGeneratorOptions(int argc, char* argv[], GeneratorOptions& options) {
+    if (argc < 3 || atoi(argv[2]) <= 0) return false;
+    options.count = atoi(argv[2]);
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (arg == "--output") {
+            options.outputPath = value;
+        } else if (arg == "--threads") {
+            options.threads = atoi(value.c_str());
+        } else if (arg == "--seed") {
+            options.seed = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--clues") {
+            options.targetClues = atoi(value.c_str());
+            if (options.targetClues < 17 || options.targetClues > 80) return false;
+        } else if (arg == "--difficulty") {
+            if (!parseDifficulty(value, options.difficulty)) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parse sharded-mode arguments: its own flags, then the rest as batch options
+bool parseShardedOptions(int argc, char* argv[], ShardedOptions& options) {
+    vector<char*> batchArgs(argv, argv + min(argc, 3));
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg != "--workdir" && arg != "--workers" && arg != "--shard-size") {
+            batchArgs.push_back(argv[i]);
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (arg == "--workdir") {
+            options.workDir = value;
+        } else if (arg == "--workers") {
+            options.workers = atoi(value.c_str());
+        } else {
+            options.shardSize = strtoull(value.c_str(), nullptr, 10);
+        }
+    }
+    if (!parseBatchOptions((int)batchArgs.size(), batchArgs.data(), options.batch)) return false;
+    if (options.batch.threads != 0 || !options.batch.portfolio.empty() || !options.batch.statsPath.empty()) {
+        cerr << "Sharded runs take --workers instead of --threads, and no --portfolio or --stats\n";
+        return false;
+    }
+    return !options.workDir.empty() && options.shardSize > 0;
+}
+
+// Parse convert-mode arguments into input, output and box size
+bool parseConvertOptions(int argc, char* argv[], string& inputPath, string& outputPath, int& boxSize) {
+    if (argc != 4 && argc != 6) return false;
+    inputPath = argv[2];
+    outputPath = argv[3];
+    boxSize = 3;
+    if (argc == 6) {
+        int size = atoi(argv[5]);
+        if (string(argv[4]) != "--size" || (size != 9 && size != 16 && size != 25)) return false;
+        boxSize = size == 9 ? 3 : size == 16 ? 4 : 5;
+    }
+    return true;
+}
+
+// Parse serve-mode arguments; returns false on a usage error
+bool parseServerOptions(int argc, char* argv[], ServerOptions& options) {
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (arg == "--port") {
+            options.port = atoi(value.c_str());
+        } else if (arg == "--host") {
+            options.host = value;
+        } else if (arg == "--threads") {
+            options.threads = atoi(value.c_str());
+        } else if (arg == "--queue") {
+            options.queueDepth = max(1, atoi(value.c_str()));
+        } else if (arg == "--root") {
+            options.rootDir = value;
+        } else if (arg == "--cache") {
+            options.cacheSize = atoi(value.c_str());
+        } else if (arg == "--timeout") {
+            options.solveTimeoutMs = atof(value.c_str());
+        } else if (arg == "--batch-timeout") {
+            options.batchTimeoutMs = atof(value.c_str());
+        } else if (arg == "--max-boards") {
+            options.maxBoards = max(1, atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return options.port > 0 && options.port < 65536;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        string mode = argv[1];
+        if (mode == "--batch") {
+            BatchOptions options;
+            if (!parseBatchOptions(argc, argv, options)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            BatchStats stats;
+            if (!runBatch(options, stats)) {
+                return 1;
+            }
+            printBatchStats(options, stats, cerr);
+            return 0;
+        }
+        if (mode == "--sharded") {
+            ShardedOptions options;
+            if (!parseShardedOptions(argc, argv, options)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            BatchStats stats;
+            if (!runSharded(options, stats)) {
+                return 1;
+            }
+            printBatchStats(options.batch, stats, cerr);
+            return 0;
+        }
+        if (mode == "--serve") {
+            ServerOptions options;
+            if (!parseServerOptions(argc, argv, options)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            return runServer(options) ? 0 : 1;
+        }
+        if (mode == "--generate") {
+            GeneratorOptions options;
+            if (!parseGeneratorOptions(argc, argv, options)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            GeneratorStats stats;
+            if (!runGenerator(options, stats)) {
+                return 1;
+            }
+            printGeneratorStats(options, stats, cerr);
+            return stats.failed == 0 ? 0 : 1;
+        }
+        if (mode == "--convert") {
+            string inputPath, outputPath;
+            int boxSize;
+            if (!parseConvertOptions(argc, argv, inputPath, outputPath, boxSize)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            return convertCorpus(inputPath, outputPath, boxSize) ? 0 : 1;
+        }
+        printUsage(argv[0]);
+        return mode == "--help" ? 0 : 1;
+    }
   
     while (true) {
         cout << "\n" << string(50, '=') << "\n";
@@ -216,25 +575,24 @@ int main() {
                 solver.printBoard();
                 
                 cout << "\nChoose solving method:\n";
-                cout << "1. Backtracking\n";
-                cout << "2. Constraint Propagation\n";
-                cout << "3. Both (with comparison)\n";
-                cout << "Enter choice (1-3): ";
+                vector<SolverEngine> engines = getEngines();
+                for (size_t i = 0; i < engines.size(); i++) {
+                    cout << (i + 1) << ". " << engines[i].name << "\n";
+                }
+                int compareChoice = engines.size() + 1;
+                cout << compareChoice << ". All (with comparison)\n";
+                cout << "Enter choice (1-" << compareChoice << "): ";
                 
                 int method;
                 cin >> method;
                 
-                if (method == 1) {
-                    double time = measureTime([&]() { solver.solveBacktracking(); });
-                    cout << "\nSolution:";
-                    solver.printBoard();
-                    cout << "Time: " << fixed << setprecision(3) << time << " ms\n";
-                } else if (method == 2) {
-                    double time = measureTime([&]() { solver.solveConstraintPropagation(); });
+                if (method >= 1 && method < compareChoice) {
+                    const SolverEngine& engine = engines[method - 1];
+                    double time = measureTime([&]() { (solver.*engine.solve)(); });
                     cout << "\nSolution:";
                     solver.printBoard();
                     cout << "Time: " << fixed << setprecision(3) << time << " ms\n";
-                } else if (method == 3) {
+                } else if (method == compareChoice) {
                     compareAlgorithms(board, "Manual Input");
                 }
                 break;
@@ -6,6 +6,7 @@ class SudokuSolver {
         this.selectedAlgorithm = 'backtracking';
         this.isSolving = false;
         this.stepCount = 0;
+        this.boardId = null;
         
         this.initializeBoard();
         this.setupEventListeners();
@@ -58,6 +59,96 @@ class SudokuSolver {
         }
 
         this.updateStatus('Board updated');
+        this.checkMove(row, col, cell);
+    }
+
+    // Start a play board on the solve service for the current puzzle, so
+    // each move is checked against the board state kept there
+    async startPlayBoard() {
+        this.boardId = null;
+        try {
+            const response = await fetch('/api/board', {
+                method: 'POST',
+                headers: { 'Content-Type': 'text/plain' },
+                body: this.boardToLine(this.originalBoard)
+            });
+            if (response.ok) {
+                this.boardId = (await response.json()).board;
+            }
+        } catch (error) {
+            // No solve service: play on without live checks
+        }
+    }
+
+    // Send one move to the play board. Resolves to {legal, empty, conflicts,
+    // solvable}, or null without a play board.
+    async sendMove(row, col, digit) {
+        if (!this.boardId) return null;
+        const response = await fetch(
+            `/api/board/move?id=${this.boardId}&cell=${row * 9 + col}&digit=${digit}`, { method: 'POST' });
+        return response.ok ? response.json() : null;
+    }
+
+    // Mark a clashing entry and say whether the board can still be solved
+    async checkMove(row, col, cell) {
+        try {
+            const result = await this.sendMove(row, col, this.board[row][col]);
+            if (!result) return;
+            cell.classList.toggle('error', !result.legal);
+            if (result.conflicts > 0) {
+                this.updateStatus('A digit repeats in a row, column or box');
+            } else if (!result.solvable) {
+                this.updateStatus('No solution from here: a digit is wrong');
+            } else if (result.empty === 0) {
+                this.updateStatus('Puzzle complete!');
+            }
+        } catch (error) {
+            console.error('Error checking move:', error);
+        }
+    }
+
+    // Ask the play board for the next step: a digit to take back, or one
+    // to place (which is then placed)
+    async showHint() {
+        if (!this.boardId) {
+            this.updateStatus('Hints need a puzzle in play on the solve service (make serve)');
+            return;
+        }
+        try {
+            const response = await fetch(`/api/board/hint?id=${this.boardId}`);
+            if (!response.ok) {
+                throw new Error(`Solver error ${response.status}`);
+            }
+            const hint = await response.json();
+            const row = Math.floor(hint.cell / 9), col = hint.cell % 9;
+            const where = `row ${row + 1}, column ${col + 1}`;
+            const cell = document.querySelector(`[data-row="${row}"][data-col="${col}"]`);
+            const reasons = {
+                'naked-single': `only ${hint.digit} fits`,
+                'hidden-single': `${hint.digit} fits nowhere else in its row, column or box`,
+                'solution': `${hint.digit} (no single left, guessing from the solution)`
+            };
+
+            if (hint.hint === 'conflict' || hint.hint === 'mistake') {
+                cell.classList.add('error');
+                this.updateStatus(`Hint: remove the ${hint.digit} at ${where}` +
+                    (hint.hint === 'conflict' ? ', it repeats' : ', it leaves no solution'));
+            } else if (reasons[hint.hint]) {
+                this.board[row][col] = hint.digit;
+                cell.value = hint.digit.toString();
+                cell.classList.remove('error');
+                cell.classList.add('solved');
+                await this.sendMove(row, col, hint.digit);
+                this.updateStatus(`Hint: ${where} is ${reasons[hint.hint]}`);
+            } else if (hint.hint === 'unknown') {
+                this.updateStatus('No hint: the solver ran out of time on this board');
+            } else {
+                this.updateStatus(hint.empty === 0 ? 'Puzzle complete!' : 'No hint: the board has no solution');
+            }
+        } catch (error) {
+            console.error('Error getting hint:', error);
+            this.updateStatus(`Error getting hint: ${error.message}`);
+        }
     }
 
     // Handle key navigation
@@ -124,6 +215,7 @@ class SudokuSolver {
         // Board controls
         document.getElementById('solveBtn').addEventListener('click', () => this.solve());
         document.getElementById('resetBtn').addEventListener('click', () => this.resetBoard());
+        document.getElementById('hintBtn').addEventListener('click', () => this.showHint());
 
         // Modal
         document.getElementById('closeModal').addEventListener('click', () => this.hideModal());
@@ -186,6 +278,7 @@ class SudokuSolver {
         this.board = puzzles[difficulty].map(row => [...row]);
         this.originalBoard = puzzles[difficulty].map(row => [...row]);
         this.updateBoardDisplay();
+        this.startPlayBoard();
         this.updateStatus(`${difficulty.charAt(0).toUpperCase() + difficulty.slice(1)} puzzle loaded`);
     }
 
@@ -194,6 +287,7 @@ class SudokuSolver {
         this.board = Array(9).fill().map(() => Array(9).fill(0));
         this.originalBoard = Array(9).fill().map(() => Array(9).fill(0));
         this.updateBoardDisplay();
+        this.startPlayBoard();
         this.updateStatus('Board cleared');
     }
 
@@ -217,6 +311,31 @@ class SudokuSolver {
         }
     }
 
+    // Board as the 81-character puzzle line the solve service expects
+    boardToLine(board) {
+        return board.map(row => row.join('')).join('');
+    }
+
+    // Solve a board with one engine on the C++ solve service (make serve).
+    // Resolves to {status, solution, time_ms, nodes}.
+    async requestSolve(board, engine) {
+        const response = await fetch(`/api/solve?engine=${engine}`, {
+            method: 'POST',
+            headers: { 'Content-Type': 'text/plain' },
+            body: this.boardToLine(board)
+        });
+        if (!response.ok) {
+            throw new Error(response.status === 503 ? 'Solver busy, try again' : `Solver error ${response.status}`);
+        }
+        return response.json();
+    }
+
+    // Copy a solution line back into the board
+    applySolution(line) {
+        this.board = Array(9).fill().map((_, i) =>
+            Array(9).fill().map((_, j) => parseInt(line[i * 9 + j])));
+    }
+
     // Solve the puzzle
     async solve() {
         if (this.isSolving) return;
@@ -226,232 +345,33 @@ class SudokuSolver {
         this.showLoading();
 
         try {
-            const startTime = performance.now();
-            let solved = false;
-
-            if (this.selectedAlgorithm === 'backtracking') {
-                solved = this.solveBacktracking();
-            } else {
-                solved = this.solveConstraintPropagation();
-            }
-
-            const endTime = performance.now();
-            const solveTime = endTime - startTime;
+            const result = await this.requestSolve(this.board, this.selectedAlgorithm);
 
-            if (solved) {
+            if (result.status === 'solved') {
+                this.applySolution(result.solution);
+                this.boardId = null;
+                this.stepCount = result.nodes;
                 this.updateBoardDisplay();
-                this.updatePerformance(this.selectedAlgorithm, solveTime);
-                this.showSuccessModal(this.selectedAlgorithm, solveTime);
+                this.updatePerformance(this.selectedAlgorithm, result.time_ms);
+                this.showSuccessModal(this.selectedAlgorithm, result.time_ms);
                 this.updateStatus('Puzzle solved successfully!');
+            } else if (result.status === 'invalid') {
+                this.updateStatus('Invalid board: a digit repeats in a row, column or box');
+            } else if (result.status === 'timeout') {
+                this.updatePerformance(this.selectedAlgorithm, result.time_ms, true);
+                this.updateStatus(`Gave up after ${result.time_ms.toFixed(0)} ms: try another algorithm`);
             } else {
                 this.updateStatus('No solution found');
             }
         } catch (error) {
             console.error('Error solving puzzle:', error);
-            this.updateStatus('Error solving puzzle');
+            this.updateStatus(`Error solving puzzle: ${error.message}`);
         } finally {
             this.hideLoading();
             this.isSolving = false;
         }
     }
 
-    // Backtracking algorithm
-    solveBacktracking() {
-        const board = this.board.map(row => [...row]);
-        
-        const isValid = (row, col, num) => {
-            // Check row
-            for (let x = 0; x < 9; x++) {
-                if (board[row][x] === num) return false;
-            }
-            
-            // Check column
-            for (let x = 0; x < 9; x++) {
-                if (board[x][col] === num) return false;
-            }
-            
-            // Check 3x3 box
-            const startRow = Math.floor(row / 3) * 3;
-            const startCol = Math.floor(col / 3) * 3;
-            for (let i = 0; i < 3; i++) {
-                for (let j = 0; j < 3; j++) {
-                    if (board[i + startRow][j + startCol] === num) return false;
-                }
-            }
-            
-            return true;
-        };
-
-        const findEmptyCell = () => {
-            for (let row = 0; row < 9; row++) {
-                for (let col = 0; col < 9; col++) {
-                    if (board[row][col] === 0) {
-                        return [row, col];
-                    }
-                }
-            }
-            return null;
-        };
-
-        const solve = () => {
-            this.stepCount++;
-            const emptyCell = findEmptyCell();
-            
-            if (!emptyCell) {
-                return true; // Puzzle solved
-            }
-            
-            const [row, col] = emptyCell;
-            
-            for (let num = 1; num <= 9; num++) {
-                if (isValid(row, col, num)) {
-                    board[row][col] = num;
-                    
-                    if (solve()) {
-                        return true;
-                    }
-                    
-                    board[row][col] = 0; // Backtrack
-                }
-            }
-            
-            return false;
-        };
-
-        const result = solve();
-        if (result) {
-            // Update the main board with the solution
-            this.board = board;
-        }
-        return result;
-    }
-
-    // Constraint propagation algorithm
-    solveConstraintPropagation() {
-        const board = this.board.map(row => [...row]);
-        
-        // Initialize candidates for all empty cells
-        const candidates = Array(9).fill().map(() => 
-            Array(9).fill().map(() => new Set([1,2,3,4,5,6,7,8,9]))
-        );
-
-        // Remove candidates based on filled cells
-        for (let i = 0; i < 9; i++) {
-            for (let j = 0; j < 9; j++) {
-                if (board[i][j] !== 0) {
-                    candidates[i][j].clear();
-                    removeCandidates(candidates, i, j, board[i][j]);
-                }
-            }
-        }
-
-        const isValid = (row, col, num) => {
-            // Check row
-            for (let x = 0; x < 9; x++) {
-                if (board[row][x] === num) return false;
-            }
-            
-            // Check column
-            for (let x = 0; x < 9; x++) {
-                if (board[x][col] === num) return false;
-            }
-            
-            // Check 3x3 box
-            const startRow = Math.floor(row / 3) * 3;
-            const startCol = Math.floor(col / 3) * 3;
-            for (let i = 0; i < 3; i++) {
-                for (let j = 0; j < 3; j++) {
-                    if (board[i + startRow][j + startCol] === num) return false;
-                }
-            }
-            
-            return true;
-        };
-
-        const removeCandidates = (candidates, row, col, num) => {
-            // Remove from row
-            for (let j = 0; j < 9; j++) {
-                if (j !== col) {
-                    candidates[row][j].delete(num);
-                }
-            }
-            
-            // Remove from column
-            for (let i = 0; i < 9; i++) {
-                if (i !== row) {
-                    candidates[i][col].delete(num);
-                }
-            }
-            
-            // Remove from 3x3 box
-            const startRow = Math.floor(row / 3) * 3;
-            const startCol = Math.floor(col / 3) * 3;
-            for (let i = startRow; i < startRow + 3; i++) {
-                for (let j = startCol; j < startCol + 3; j++) {
-                    if (i !== row || j !== col) {
-                        candidates[i][j].delete(num);
-                    }
-                }
-            }
-        };
-
-        const findMinCandidates = () => {
-            let minCandidates = 10;
-            let minCell = null;
-            
-            for (let i = 0; i < 9; i++) {
-                for (let j = 0; j < 9; j++) {
-                    if (board[i][j] === 0 && candidates[i][j].size < minCandidates) {
-                        minCandidates = candidates[i][j].size;
-                        minCell = [i, j];
-                    }
-                }
-            }
-            
-            return minCell;
-        };
-
-        const solve = () => {
-            this.stepCount++;
-            const minCell = findMinCandidates();
-            
-            if (!minCell) {
-                return true; // Puzzle solved
-            }
-            
-            const [row, col] = minCell;
-            const currentCandidates = new Set(candidates[row][col]);
-            
-            for (const num of currentCandidates) {
-                if (isValid(row, col, num)) {
-                    board[row][col] = num;
-                    
-                    // Create new candidates state
-                    const newCandidates = candidates.map(row => 
-                        row.map(cell => new Set(cell))
-                    );
-                    newCandidates[row][col].clear();
-                    removeCandidates(newCandidates, row, col, num);
-                    
-                    if (solve()) {
-                        return true;
-                    }
-                    
-                    board[row][col] = 0; // Backtrack
-                }
-            }
-            
-            return false;
-        };
-
-        const result = solve();
-        if (result) {
-            // Update the main board with the solution
-            this.board = board;
-        }
-        return result;
-    }
-
     // Compare both algorithms
     async compareAlgorithms() {
         if (this.isSolving) return;
@@ -460,60 +380,60 @@ class SudokuSolver {
         this.showLoading();
 
         try {
-            const boardCopy = this.board.map(row => [...row]);
-            
-            // Test backtracking
-            this.board = boardCopy.map(row => [...row]);
-            const backtrackingStart = performance.now();
-            const backtrackingSolved = this.solveBacktracking();
-            const backtrackingTime = performance.now() - backtrackingStart;
-            
-            // Test constraint propagation
-            this.board = boardCopy.map(row => [...row]);
-            const constraintStart = performance.now();
-            const constraintSolved = this.solveConstraintPropagation();
-            const constraintTime = performance.now() - constraintStart;
-            
+            const [backtracking, constraint] = await Promise.all([
+                this.requestSolve(this.board, 'backtracking'),
+                this.requestSolve(this.board, 'constraint')
+            ]);
+
             // Update performance display
-            this.updatePerformance('backtracking', backtrackingTime);
-            this.updatePerformance('constraint', constraintTime);
-            
-            // Calculate speedup
-            if (constraintTime > 0 && backtrackingTime > 0) {
-                const speedup = backtrackingTime / constraintTime;
-                document.getElementById('speedup').textContent = `${speedup.toFixed(2)}x`;
+            const backtrackingTimedOut = backtracking.status === 'timeout';
+            const constraintTimedOut = constraint.status === 'timeout';
+            this.updatePerformance('backtracking', backtracking.time_ms, backtrackingTimedOut);
+            this.updatePerformance('constraint', constraint.time_ms, constraintTimedOut);
+
+            // Calculate speedup (a timed-out run has no time to compare)
+            const speedupText = document.getElementById('speedup');
+            if (backtrackingTimedOut || constraintTimedOut) {
+                speedupText.textContent = '-';
+            } else if (constraint.time_ms > 0 && backtracking.time_ms > 0) {
+                const speedup = backtracking.time_ms / constraint.time_ms;
+                speedupText.textContent = `${speedup.toFixed(2)}x`;
             }
-            
-            // Use the faster solution for display
-            if (constraintTime < backtrackingTime) {
-                this.board = boardCopy.map(row => [...row]);
-                this.solveConstraintPropagation();
-                this.selectedAlgorithm = 'constraint';
+
+            // Use the faster solution for display; a run that timed out never wins
+            const faster = constraintTimedOut || (!backtrackingTimedOut && backtracking.time_ms <= constraint.time_ms)
+                ? backtracking : constraint;
+            this.selectedAlgorithm = faster === constraint ? 'constraint' : 'backtracking';
+            if (faster.status === 'solved') {
+                this.applySolution(faster.solution);
+                this.boardId = null;
+                this.updateBoardDisplay();
+                this.updateStatus(backtrackingTimedOut || constraintTimedOut
+                    ? `Algorithm comparison completed: ${backtrackingTimedOut ? 'backtracking' : 'constraint'} timed out`
+                    : 'Algorithm comparison completed');
+            } else if (faster.status === 'timeout') {
+                this.updateStatus('Both algorithms timed out');
             } else {
-                this.board = boardCopy.map(row => [...row]);
-                this.solveBacktracking();
-                this.selectedAlgorithm = 'backtracking';
+                this.updateStatus('No solution found');
             }
-            
-            this.updateBoardDisplay();
             this.updateAlgorithmButtons();
-            this.updateStatus('Algorithm comparison completed');
-            
+
         } catch (error) {
             console.error('Error comparing algorithms:', error);
-            this.updateStatus('Error comparing algorithms');
+            this.updateStatus(`Error comparing algorithms: ${error.message}`);
         } finally {
             this.hideLoading();
             this.isSolving = false;
         }
     }
 
-    // Update performance display
-    updatePerformance(algorithm, time) {
+    // Update performance display; a run that timed out shows how long it tried
+    updatePerformance(algorithm, time, timedOut = false) {
+        const text = timedOut ? `> ${time.toFixed(0)} ms (timeout)` : `${time.toFixed(2)} ms`;
         if (algorithm === 'backtracking') {
-            document.getElementById('backtrackingTime').textContent = `${time.toFixed(2)} ms`;
+            document.getElementById('backtrackingTime').textContent = text;
         } else if (algorithm === 'constraint') {
-            document.getElementById('constraintTime').textContent = `${time.toFixed(2)} ms`;
+            document.getElementById('constraintTime').textContent = text;
         }
     }
 
@@ -521,6 +441,7 @@ class SudokuSolver {
     resetBoard() {
         this.board = this.originalBoard.map(row => [...row]);
         this.updateBoardDisplay();
+        this.startPlayBoard();
         this.updateStatus('Board reset to original');
     }
 
@@ -558,4 +479,4 @@ class SudokuSolver {
 // Initialize the application when DOM is loaded
 document.addEventListener('DOMContentLoaded', () => {
     new SudokuSolver();
-}); 
\ No newline at end of file
+}); 
@@ -0,0 +1,88 @@
+/*
+ * C interface to the 9x9 solver, built into libsudoku.a / libsudoku.so
+ * (make lib). Nothing here allocates or throws: each caller passes a scratch
+ * block it owns, and the solver lives in that block. One scratch block per
+ * thread lets any number of threads solve at once.
+ *
+ *     unsigned char memory[4096];   (at least sudoku_scratch_size() bytes)
+ *     sudoku_scratch* scratch = sudoku_scratch_init(memory, sizeof(memory));
+ *     char solution[81];
+ *     int status = sudoku_solve(puzzle, solution, NULL, scratch);
+ *     sudoku_scratch_release(scratch);
+ */
+#ifndef SUDOKU_H
+#define SUDOKU_H
+
+#include <stddef.h>
+
+/* The shared library is built with hidden visibility; only these are exported */
+#if defined(__GNUC__)
+#define SUDOKU_API __attribute__((visibility("default")))
+#else
+#define SUDOKU_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Result of sudoku_solve */
+enum sudoku_status {
+    SUDOKU_SOLVED = 0,
+    SUDOKU_UNSOLVABLE = 1,
+    SUDOKU_INVALID = 2,          /* bad character, or givens that clash */
+    SUDOKU_MULTIPLE = 3,         /* more than one solution (check_unique only) */
+    SUDOKU_TIMED_OUT = 4,        /* over timeout_ms or max_nodes */
+    SUDOKU_ERROR = 5             /* null argument or scratch not initialized */
+};
+
+/* Engines that run without allocating */
+enum sudoku_engine {
+    SUDOKU_ENGINE_BITMASK = 0,   /* candidate bitmasks with inference rules (default) */
+    SUDOKU_ENGINE_BACKTRACKING = 1
+};
+
+/* Inference rules of the bitmask engine, OR-ed together */
+#define SUDOKU_RULE_HIDDEN_SINGLES 0x01u
+#define SUDOKU_RULE_NAKED_PAIRS    0x02u
+#define SUDOKU_RULE_HIDDEN_PAIRS   0x04u
+#define SUDOKU_RULE_POINTING       0x08u
+#define SUDOKU_RULE_BOX_LINE       0x10u
+#define SUDOKU_ALL_RULES           0x1Fu
+
+typedef struct sudoku_options {
+    int engine;                  /* enum sudoku_engine */
+    unsigned rules;              /* SUDOKU_RULE_* bits, 0 for naked singles only */
+    int check_unique;            /* nonzero to report SUDOKU_MULTIPLE */
+    double timeout_ms;           /* 0 for no deadline */
+    unsigned long long max_nodes; /* 0 for no node budget */
+} sudoku_options;
+
+/* Solver state inside a caller's scratch block */
+typedef struct sudoku_scratch sudoku_scratch;
+
+/* Bytes of scratch sudoku_scratch_init needs, at any alignment */
+SUDOKU_API size_t sudoku_scratch_size(void);
+
+/* Set up a solver in `memory`; NULL if `size` is too small */
+SUDOKU_API sudoku_scratch* sudoku_scratch_init(void* memory, size_t size);
+
+/* Tear the solver down; the memory is the caller's again */
+SUDOKU_API void sudoku_scratch_release(sudoku_scratch* scratch);
+
+/* Bitmask engine, every rule, no uniqueness check, no limits */
+SUDOKU_API void sudoku_default_options(sudoku_options* options);
+
+/* Solve `in` (81 characters, '1'-'9' for givens, '0' or '.' for empty
+ * cells, no terminator needed) into `out` (81 digit characters, not
+ * terminated; left untouched unless solved). `options` may be NULL. */
+SUDOKU_API int sudoku_solve(const char* in, char* out, const sudoku_options* options, sudoku_scratch* scratch);
+
+/* "solved", "unsolvable", ... for a status */
+SUDOKU_API const char* sudoku_status_name(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif